@@ -56,6 +56,7 @@ MSG_SYMBOL_TABLE       = ${quote} SYM         $(MSG_EXTRA)${quote}
 MSG_ENCRYPT            = ${quote} ENCRYPT     $(MSG_EXTRA)${quote}
 MSG_IMAGE_INFO         = ${quote} IMAGE-INFO  $(MSG_EXTRA)${quote}
 MSG_LOG_TEXTS          = ${quote} LOG-TEXTS   $(MSG_EXTRA)${quote}
+MSG_RAMTEXT            = ${quote} RAMTEXT     $(MSG_EXTRA)${quote}
 
 toprel = $(subst $(realpath $(ROOT_DIR))/,,$(abspath $(1)))
 
@@ -105,6 +106,16 @@ $(1)_size: $(1)
 	$(V1) $(SIZE) -B $$<
 endef
 
+# Report the amount of code that is copied to and executed from RAM. Taken
+# from the map file, after --gc-sections.
+#   $(1) = elf file, linked with -Map=<elf file without extension>.map
+define RAMTEXT_TEMPLATE
+.PHONY: ramtext
+ramtext: $(1)
+	$(V0) @echo $(MSG_RAMTEXT) $(TARGET)
+	$(V1) awk -f $(ROOT_DIR)/make/ramtext.awk $(basename $(1)).map
+endef
+
 # Assemble: create object files from assembler source files.
 define ASSEMBLE_THUMB_TEMPLATE
 $(OUTDIR)/$(notdir $(basename $(1))).o : $(1) $(2) | $(OUTDIR)
@@ -0,0 +1,84 @@
+# Prints the boot stages of src/common/fw/boottime.h and the module ready
+# times of src/common/fw/startup.h.
+#
+# Usage from arm-none-eabi-gdb, attached to the target through OpenOCD:
+#
+#   (gdb) source make/gdb/boottime.py
+#   (gdb) boottime [CPU_HZ [HSI_HZ]]
+#
+# Times are core cycles since reset, CPU_HZ shows them in milliseconds.
+# The cycles up to clock_init count at HSI_HZ, 16 MHz by default (8 MHz
+# on STM32F0). Cortex-M0 times the stages up to boardInit in steps of 8
+# cycles.
+
+import gdb
+
+# src/common/fw/boottime.h
+BOOTTIME_MAGIC = 0x42544D32
+
+
+class BoottimeCommand(gdb.Command):
+    """Print the time of each boot stage and module start-up.
+
+Usage: boottime [CPU_HZ [HSI_HZ]]"""
+
+    def __init__(self):
+        super(BoottimeCommand, self).__init__("boottime", gdb.COMMAND_DATA)
+
+    def invoke(self, argument, from_tty):
+        args = gdb.string_to_argv(argument)
+        cpu_hz = int(args[0]) if args else 0
+        hsi_hz = int(args[1]) if len(args) > 1 else 16000000
+
+        record = gdb.parse_and_eval("boottime_record")
+        if int(record["magic"]) != BOOTTIME_MAGIC:
+            print("boottime_record not initialized")
+            return
+
+        names = gdb.parse_and_eval("boottime_stage_names")
+        stages = record["stages"]
+        clock_init = int(stages[1])
+
+        def elapsed(cycles):
+            """Cycles since reset in the unit of the output."""
+            if not cpu_hz:
+                return cycles
+            if cycles <= clock_init:
+                return cycles * 1e3 / hsi_hz
+            return (clock_init * 1e3 / hsi_hz +
+                    (cycles - clock_init) * 1e3 / cpu_hz)
+
+        def show(value):
+            if cpu_hz:
+                return "%10.3f ms" % value
+            return "%10d cyc" % value
+
+        print("boot %d since power on" % int(record["boots"]))
+        previous = None
+        for stage in range(stages.type.range()[1] + 1):
+            name = names[stage].string()
+            cycles = int(stages[stage])
+            if cycles == 0 and stage != 0:
+                print("  %-16s %14s" % (name, "n/a"))
+                continue
+            line = "  %-16s %s" % (name, show(elapsed(cycles)))
+            if previous is not None:
+                line += "  +%s" % show(elapsed(cycles) - previous).strip()
+            print(line)
+            previous = elapsed(cycles)
+
+        offset = int(record["offset"])
+        ready = gdb.parse_and_eval("startup_ready_cycles")
+        print("module ready")
+        for field in gdb.lookup_type("enum startup_module").fields():
+            if field.enumval > ready.type.range()[1]:
+                continue
+            name = field.name.replace("STARTUP_MOD_", "").lower()
+            cycles = int(ready[field.enumval])
+            if cycles == 0:
+                print("  %-16s %14s" % (name, "pending"))
+            else:
+                print("  %-16s %s" % (name, show(elapsed((cycles + offset) & 0xFFFFFFFF))))
+
+
+BoottimeCommand()
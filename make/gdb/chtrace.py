@@ -0,0 +1,195 @@
+# Converts the ChibiOS kernel trace buffer into a Chrome trace event file.
+#
+# Usage from arm-none-eabi-gdb, attached to the target through OpenOCD:
+#
+#   (gdb) source make/gdb/chtrace.py
+#   (gdb) chtrace trace.json [TICK_HZ [CPU_HZ]]
+#
+# TICK_HZ is CH_CFG_ST_FREQUENCY of the target, 1000 by default. CPU_HZ
+# is the realtime counter clock, without it only the system time is used.
+# Cortex-M0 has no realtime counter, events within one tick are then
+# spread evenly.
+#
+# Open the file in chrome://tracing or ui.perfetto.dev. Threads show as
+# one track each, interrupts on their own track, TRACE_BEGIN()/TRACE_END()
+# spans nested in the thread which recorded them.
+
+import json
+
+import gdb
+
+TRACE_TYPE_SWITCH = 1
+TRACE_TYPE_ISR_ENTER = 2
+TRACE_TYPE_ISR_LEAVE = 3
+TRACE_TYPE_HALT = 4
+TRACE_TYPE_USER = 5
+
+TRACE_USER_BEGIN = 1
+TRACE_USER_END = 2
+
+RTSTAMP_BITS = 24
+
+# CH_STATE_NAMES of ChibiOS/RT 5.
+THREAD_STATES = [
+    "READY", "CURRENT", "WTSTART", "SUSPENDED", "QUEUED", "WTSEM", "WTMTX",
+    "WTCOND", "SLEEPING", "WTEXIT", "WTOREVT", "WTANDEVT", "SNDMSGQ",
+    "SNDMSG", "WTMSG", "FINAL",
+]
+
+ISR_TID = 0
+
+
+def read_string(pointer):
+    if int(pointer) == 0:
+        return None
+    try:
+        return pointer.cast(gdb.lookup_type("char").pointer()).string()
+    except gdb.MemoryError:
+        return "0x%08x" % int(pointer)
+
+
+def read_events():
+    """Returns the recorded events, oldest first."""
+    trace = gdb.parse_and_eval("ch.dbg.trace_buffer")
+    buffer = trace["buffer"]
+    size = int(trace["size"])
+    start = int(trace["ptr"] - buffer[0].address)
+
+    events = []
+    for i in range(size):
+        event = buffer[(start + i) % size]
+        if int(event["type"]) != 0:
+            events.append(event)
+    return events
+
+
+def timestamps(events, tick_hz, cpu_hz):
+    """Microseconds since the first event."""
+    result = []
+    if not events:
+        return result
+
+    first_time = int(events[0]["time"])
+    wrap = 1 << RTSTAMP_BITS
+    fine = 0.0
+    for index, event in enumerate(events):
+        coarse = ((int(event["time"]) - first_time) & 0xFFFFFFFF) * \
+            1e6 / tick_hz
+        if cpu_hz and index > 0:
+            # The counter wraps within a few ticks, use it for the
+            # distance to the previous event only.
+            delta = (int(event["rtstamp"]) -
+                     int(events[index - 1]["rtstamp"])) % wrap
+            fine += delta * 1e6 / cpu_hz
+            if abs(fine - coarse) > 1e6 / tick_hz:
+                fine = coarse
+            result.append(fine)
+        else:
+            fine = coarse
+            result.append(coarse)
+
+    if not cpu_hz:
+        # Spread events of the same tick so they keep their order.
+        index = 0
+        while index < len(result):
+            end = index
+            while end < len(result) and result[end] == result[index]:
+                end += 1
+            step = 1e6 / tick_hz / (end - index)
+            for i in range(index, end):
+                result[i] += (i - index) * step
+            index = end
+    return result
+
+
+class ChromeTrace:
+    def __init__(self):
+        self.events = []
+        self.threads = {}
+
+    def thread(self, pointer):
+        address = int(pointer)
+        if address not in self.threads:
+            tid = len(self.threads) + 1
+            thread = pointer.cast(
+                gdb.lookup_type("thread_t").pointer()).dereference()
+            name = read_string(thread["name"]) or "0x%08x" % address
+            self.threads[address] = tid
+            self.events.append({"ph": "M", "pid": 0, "tid": tid,
+                                "name": "thread_name",
+                                "args": {"name": name}})
+        return self.threads[address]
+
+    def add(self, **event):
+        event.setdefault("pid", 0)
+        self.events.append(event)
+
+
+def convert(events, tick_hz, cpu_hz):
+    chrome = ChromeTrace()
+    chrome.add(ph="M", tid=ISR_TID, name="thread_name",
+               args={"name": "interrupts"})
+
+    current = None
+    running_since = 0.0
+    times = timestamps(events, tick_hz, cpu_hz)
+    for event, ts in zip(events, times):
+        kind = int(event["type"])
+        if kind == TRACE_TYPE_SWITCH:
+            if current is not None:
+                state = int(event["state"])
+                chrome.add(ph="X", tid=current, name="running",
+                           ts=running_since, dur=ts - running_since,
+                           args={"next state": THREAD_STATES[state]
+                                 if state < len(THREAD_STATES) else state})
+            current = chrome.thread(event["u"]["sw"]["ntp"])
+            running_since = ts
+        elif kind in (TRACE_TYPE_ISR_ENTER, TRACE_TYPE_ISR_LEAVE):
+            name = read_string(event["u"]["isr"]["name"]) or "isr"
+            chrome.add(ph="B" if kind == TRACE_TYPE_ISR_ENTER else "E",
+                       tid=ISR_TID, name=name, ts=ts)
+        elif kind == TRACE_TYPE_HALT:
+            reason = read_string(event["u"]["halt"]["reason"]) or "halt"
+            chrome.add(ph="i", s="g", tid=ISR_TID, name=reason, ts=ts)
+        elif kind == TRACE_TYPE_USER:
+            name = read_string(event["u"]["user"]["up1"]) or "user"
+            mark = int(event["u"]["user"]["up2"])
+            tid = current if current is not None else ISR_TID
+            if mark == TRACE_USER_BEGIN:
+                chrome.add(ph="B", tid=tid, name=name, ts=ts)
+            elif mark == TRACE_USER_END:
+                chrome.add(ph="E", tid=tid, name=name, ts=ts)
+            else:
+                chrome.add(ph="i", s="t", tid=tid, name=name, ts=ts,
+                           args={"value": mark})
+
+    if current is not None and times:
+        chrome.add(ph="X", tid=current, name="running", ts=running_since,
+                   dur=times[-1] - running_since)
+
+    return {"traceEvents": chrome.events, "displayTimeUnit": "ns"}
+
+
+class ChTraceCommand(gdb.Command):
+    """Write the kernel trace buffer as Chrome trace events.
+
+Usage: chtrace FILE [TICK_HZ [CPU_HZ]]"""
+
+    def __init__(self):
+        super(ChTraceCommand, self).__init__("chtrace", gdb.COMMAND_DATA)
+
+    def invoke(self, argument, from_tty):
+        args = gdb.string_to_argv(argument)
+        if not args or len(args) > 3:
+            raise gdb.GdbError("usage: chtrace FILE [TICK_HZ [CPU_HZ]]")
+
+        tick_hz = int(args[1]) if len(args) > 1 else 1000
+        cpu_hz = int(args[2]) if len(args) > 2 else 0
+
+        events = read_events()
+        with open(args[0], "w") as output:
+            json.dump(convert(events, tick_hz, cpu_hz), output, indent=1)
+        print("chtrace: %d events written to %s" % (len(events), args[0]))
+
+
+ChTraceCommand()
@@ -0,0 +1,53 @@
+# Prints the write statistics of src/modules/mod_logger.
+#
+# Usage from arm-none-eabi-gdb, attached to the target through OpenOCD:
+#
+#   (gdb) source make/gdb/logger.py
+#   (gdb) logger [CPU_HZ]
+#
+# Write times are cycles of cyclecount_get(), CPU_HZ shows them in
+# milliseconds. The throughput is computed on the target, over the time
+# spent writing only.
+
+import gdb
+
+INSTANCE = "'qos::Singleton<blinky::ModuleLogger>::instance'"
+
+
+def scale(cycles, cpu_hz):
+    if cpu_hz:
+        return "%10.3f ms" % (cycles * 1e3 / cpu_hz)
+    return "%10d cyc" % cycles
+
+
+class LoggerCommand(gdb.Command):
+    """Print blocks written and dropped, write time and throughput.
+
+Usage: logger [CPU_HZ]"""
+
+    def __init__(self):
+        super(LoggerCommand, self).__init__("logger", gdb.COMMAND_DATA)
+
+    def invoke(self, argument, from_tty):
+        args = gdb.string_to_argv(argument)
+        cpu_hz = int(args[0]) if args else 0
+
+        try:
+            logger = gdb.parse_and_eval(INSTANCE)
+        except gdb.error:
+            print("no logger in this build, see MOD_LOGGER")
+            return
+
+        stats = logger["stats"]
+        print("storage %s" % (
+            "ready" if int(logger["storageReady"]) else "not available"))
+        print("  blocks written   %10d" % int(stats["blocksWritten"]))
+        print("  blocks dropped   %10d" % int(stats["blocksDropped"]))
+        print("  write last       %s" % scale(
+            int(stats["writeCyclesLast"]), cpu_hz))
+        print("  write worst      %s" % scale(
+            int(stats["writeCyclesWorst"]), cpu_hz))
+        print("  throughput       %10d B/s" % int(stats["bytesPerSecond"]))
+
+
+LoggerCommand()
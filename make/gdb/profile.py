@@ -0,0 +1,126 @@
+# Prints the profiling zones of src/common/fw/profile.h.
+#
+# Usage from arm-none-eabi-gdb, attached to the target through OpenOCD:
+#
+#   (gdb) source make/gdb/profile.py
+#   (gdb) profile [CPU_HZ]
+#
+# Durations are core cycles, CPU_HZ adds them in microseconds. The
+# histogram shows one column per power of two from the shortest to the
+# longest bin in use.
+#
+# The DrawEffects zone is the frame time. On blinky, the render loop runs
+# from RAM. To see what that gains, build once more with NORAMTEXT=1 and
+# compare the zone after the same run time. Flash wait states depend on
+# HCLK, so keep CLOCKSCALE_ENABLE at FALSE for both builds. On
+# discoveryf407cpp the effects module lives in CCM, build with NOCCM=1 to
+# compare against main RAM shared with the WS281x DMA.
+#
+# The Color* zones only fill in a discoveryf407cpp debug build with
+# KERNELBENCH=1. The effects thread runs every color kernel 64 times on 61
+# pixels before its first frame, once packed with the DSP instructions and
+# once portable.
+#
+#   (gdb) idle [CPU_HZ [RUN_MA SLEEP_MA]]
+#   (gdb) idle reset
+#
+# Prints the wake-ups and CPU load of src/common/fw/idlestat.h. With the
+# supply current measured once at full load (RUN_MA) and once asleep in
+# WFI (SLEEP_MA) it estimates the average current from the load. Wake-ups
+# are only meaningful with CORTEX_ENABLE_WFI_IDLE, i.e. release or
+# TICKLESS=1 builds. Compare a build with and without TICKLESS=1.
+
+import gdb
+
+
+def scale(cycles, cpu_hz):
+    if cpu_hz:
+        return "%10.1f us" % (cycles * 1e6 / cpu_hz)
+    return "%10d cyc" % cycles
+
+
+class ProfileCommand(gdb.Command):
+    """Print count, min, mean, max and log2 histogram of each zone.
+
+Usage: profile [CPU_HZ]"""
+
+    def __init__(self):
+        super(ProfileCommand, self).__init__("profile", gdb.COMMAND_DATA)
+
+    def invoke(self, argument, from_tty):
+        args = gdb.string_to_argv(argument)
+        cpu_hz = int(args[0]) if args else 0
+
+        stats = gdb.parse_and_eval("profile_stats")
+        names = gdb.parse_and_eval("profile_zone_names")
+        zones = stats.type.range()[1] + 1
+
+        for zone in range(zones):
+            entry = stats[zone]
+            name = names[zone].string()
+            count = int(entry["count"])
+            if count == 0:
+                print("%-16s no samples" % name)
+                continue
+
+            mean = int(entry["total"]) // count
+            print("%-16s n=%-8d min %s  mean %s  max %s" % (
+                name, count, scale(int(entry["min"]), cpu_hz),
+                scale(mean, cpu_hz), scale(int(entry["max"]), cpu_hz)))
+
+            histogram = entry["histogram"]
+            bins = [int(histogram[i])
+                    for i in range(histogram.type.range()[1] + 1)]
+            used = [i for i, n in enumerate(bins) if n]
+            for i in range(used[0], used[-1] + 1):
+                bar = "#" * (1 + 40 * bins[i] // max(bins)) if bins[i] else ""
+                print("    >= 2^%-2d %8d %s" % (i, bins[i], bar))
+
+
+ProfileCommand()
+
+
+class IdleCommand(gdb.Command):
+    """Print idle wake-ups, CPU load and an estimated supply current.
+
+Usage: idle [CPU_HZ [RUN_MA SLEEP_MA]]
+       idle reset"""
+
+    def __init__(self):
+        super(IdleCommand, self).__init__("idle", gdb.COMMAND_DATA)
+
+    def invoke(self, argument, from_tty):
+        args = gdb.string_to_argv(argument)
+        if args and args[0] == "reset":
+            gdb.execute("set var idlestat.wakeups = 0")
+            gdb.execute("set var idlestat.switches = 0")
+            gdb.execute("set var idlestat.idle_cycles = 0")
+            gdb.execute("set var idlestat.busy_cycles = 0")
+            return
+
+        cpu_hz = int(args[0]) if args else 0
+        stats = gdb.parse_and_eval("idlestat")
+        idle = int(stats["idle_cycles"])
+        busy = int(stats["busy_cycles"])
+        total = idle + busy
+        if total == 0:
+            print("no idle statistics yet")
+            return
+
+        wakeups = int(stats["wakeups"])
+        switches = int(stats["switches"])
+        load = busy / float(total)
+        print("load %.1f %%, %d wake-ups, %d left for a thread" % (
+            100.0 * load, wakeups, switches))
+        if cpu_hz:
+            seconds = total / float(cpu_hz)
+            print("over %.1f s: %.0f wake-ups/s, %.0f switches/s" % (
+                seconds, wakeups / seconds, switches / seconds))
+        if len(args) >= 3:
+            run_ma = float(args[1])
+            sleep_ma = float(args[2])
+            print("estimated %.2f mA" % (load * run_ma +
+                                          (1.0 - load) * sleep_ma))
+
+
+IdleCommand()
@@ -0,0 +1,53 @@
+# Prints the watchdog record of src/common/fw/watchdog.h, which survives
+# the reset caused by a starving module.
+#
+# Usage from arm-none-eabi-gdb, attached to the target through OpenOCD:
+#
+#   (gdb) source make/gdb/watchdog.py
+#   (gdb) watchdog [TICK_HZ]
+#
+# TICK_HZ is CH_CFG_ST_FREQUENCY of the target, 1000 by default.
+
+import gdb
+
+# src/common/fw/watchdog.h
+WATCHDOG_MAGIC = 0x57444731
+WATCHDOG_NONE = 0xFFFFFFFF
+
+
+class WatchdogCommand(gdb.Command):
+    """Print missed deadlines per source and the last offender.
+
+Usage: watchdog [TICK_HZ]"""
+
+    def __init__(self):
+        super(WatchdogCommand, self).__init__("watchdog", gdb.COMMAND_DATA)
+
+    def invoke(self, argument, from_tty):
+        args = gdb.string_to_argv(argument)
+        tick_hz = int(args[0]) if args else 1000
+
+        record = gdb.parse_and_eval("watchdog_record")
+        if int(record["magic"]) != WATCHDOG_MAGIC:
+            print("watchdog_record not initialized")
+            return
+
+        names = {}
+        for field in gdb.lookup_type("enum watchdog_source").fields():
+            names[int(field.enumval)] = field.name.replace("WATCHDOG_", "")
+
+        missed = record["missed"]
+        for source in range(missed.type.range()[1] + 1):
+            print("  %-16s missed %d" % (names.get(source, source),
+                                         int(missed[source])))
+
+        offender = int(record["last_offender"])
+        if offender == WATCHDOG_NONE:
+            print("no deadline missed")
+        else:
+            late = int(record["last_overdue"])
+            print("last offender %s, %d ticks (%.1f ms) late" % (
+                names.get(offender, offender), late, late * 1e3 / tick_hz))
+
+
+WatchdogCommand()
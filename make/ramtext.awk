@@ -0,0 +1,37 @@
+# Sums the .ram0_init.ramtext input sections kept in a GNU ld map file,
+# i.e. the code copied to and executed from RAM (RAM_SECTION_TEXT).
+#
+# Usage: awk -f ramtext.awk firmware.map
+#
+# Sections removed by --gc-sections are listed before the memory map and
+# are not counted. Long section names put address and size on the next
+# line.
+
+function hex(s,    i, n)
+{
+    n = 0
+    s = tolower(s)
+    sub(/^0x/, "", s)
+    for (i = 1; i <= length(s); i++)
+        n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+    return n
+}
+
+/^Linker script and memory map/ { mapped = 1; next }
+
+!mapped { next }
+
+pending {
+    bytes += hex($2)
+    pending = 0
+    next
+}
+
+/^ \.ram0_init\.ramtext/ {
+    if (NF >= 3)
+        bytes += hex($3)
+    else
+        pending = 1
+}
+
+END { print bytes + 0, "bytes of code moved to RAM" }
@@ -20,7 +20,7 @@ LDFLAGS += -lpthread
 
 EXTRAINCDIRS += .
 ALLSRC := $(CSRC) $(wildcard ./*.c)
-ALLCPPSRC := $(wildcard ./*.cpp) $(GTEST_DIR)/src/gtest_main.cc
+ALLCPPSRC := $(CPPSRC) $(wildcard ./*.cpp) $(GTEST_DIR)/src/gtest_main.cc
 ALLSRCBASE := $(notdir $(basename $(ALLSRC) $(ALLCPPSRC)))
 ALLOBJ := $(addprefix $(OUTDIR)/, $(addsuffix .o, $(ALLSRCBASE)))
 
@@ -12,7 +12,7 @@
     limitations under the License.
 */
 
-#include "../../targets/discoveryf407/bg/target_cfg.h"
+#include "target_cfg.h"
 
 /*
  * Application entry point.
@@ -41,7 +41,7 @@ int main(void)
     chSysDisable();
 
     /* Wake up or continue sleeping. */
-    if (false)
+    if (boardWakeupMotion())
         boardJumpToApplication(FW_ORIGIN);
     else
         boardStandby();
@@ -0,0 +1,105 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "boottime.h"
+
+#include "cyclecount.h"
+
+#include <string.h>
+
+boottime_record_t boottime_record BOOTTIME_SECTION;
+
+const char *const boottime_stage_names[BOOTTIME_STAGE_COUNT] =
+{
+    [BOOTTIME_RESET] = "reset",
+    [BOOTTIME_CLOCK_INIT] = "clock_init",
+    [BOOTTIME_BOARD_INIT] = "boardInit",
+    [BOOTTIME_HAL_INIT] = "halInit",
+    [BOOTTIME_KERNEL_INIT] = "chSysInit",
+    [BOOTTIME_BOARD_START] = "boardStart",
+    [BOOTTIME_MODULES_INIT] = "modules_init",
+    [BOOTTIME_MODULES_START] = "modules_start",
+    [BOOTTIME_FIRST_FRAME] = "first_frame",
+};
+
+#if BOOTTIME_ENABLE
+#if CORTEX_MODEL < 3
+/* Without CLKSOURCE, the STM32 clocks SysTick with HCLK / 8. */
+#define BOOTTIME_SYSTICK_DIV        8U
+#define BOOTTIME_SYSTICK_MASK       SysTick_LOAD_RELOAD_Msk
+
+/* The first stages run before crt0, keep these uninitialized as well. */
+static uint32_t boottime_systick_last BOOTTIME_SECTION;
+static uint32_t boottime_systick_cycles BOOTTIME_SECTION;
+
+static void boottime_systick_start(void)
+{
+    SysTick->LOAD = BOOTTIME_SYSTICK_MASK;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_ENABLE_Msk;
+    boottime_systick_last = 0;
+    boottime_systick_cycles = 0;
+}
+
+/* Core cycles at the current clock, marks must be less than 2^24
+ * SysTick counts apart. */
+static uint32_t boottime_systick_get(void)
+{
+    uint32_t val = SysTick->VAL;
+
+    boottime_systick_cycles += ((boottime_systick_last - val) &
+            BOOTTIME_SYSTICK_MASK) * BOOTTIME_SYSTICK_DIV;
+    boottime_systick_last = val;
+    return boottime_systick_cycles;
+}
+#endif /* CORTEX_MODEL < 3 */
+
+/* Runs before .data and .bss are initialized, must not use either. */
+void boottime_begin(void)
+{
+    if (boottime_record.magic == BOOTTIME_MAGIC)
+    {
+        boottime_record.boots++;
+    }
+    else
+    {
+        boottime_record.magic = BOOTTIME_MAGIC;
+        boottime_record.boots = 0;
+    }
+    boottime_record.offset = 0;
+    memset(boottime_record.stages, 0, sizeof(boottime_record.stages));
+
+#if CORTEX_MODEL < 3
+    boottime_systick_start();
+#endif /* CORTEX_MODEL < 3 */
+    boottime_mark(BOOTTIME_RESET);
+}
+
+void boottime_mark(enum boottime_stage stage)
+{
+#if CORTEX_MODEL < 3
+    /* boardInit() is the last stage before stInit(), where the count of
+     * cyclecount_get() starts. */
+    if (stage <= BOOTTIME_BOARD_INIT)
+    {
+        boottime_record.stages[stage] = boottime_systick_get();
+        if (stage == BOOTTIME_BOARD_INIT)
+            boottime_record.offset = boottime_record.stages[stage];
+        return;
+    }
+#endif /* CORTEX_MODEL < 3 */
+
+    boottime_record.stages[stage] = cyclecount_get() + boottime_record.offset;
+}
+#endif /* BOOTTIME_ENABLE */
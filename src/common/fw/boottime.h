@@ -0,0 +1,98 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef BOOTTIME_H_
+#define BOOTTIME_H_
+
+#include "target_cfg.h"
+
+#include <stdint.h>
+
+/*
+ * Time from reset to the first LED frame, split into boot stages. Each
+ * stage stores cyclecount_get() at its end in boottime_record, which lives
+ * in RAM not initialized by the startup code, so it is still there when
+ * a debugger attaches after boot. The boottime command of
+ * make/gdb/boottime.py prints it together with startup_ready_cycles[].
+ *
+ * ARMv7-M counts from __early_init, the stages up to stm32_clock_init()
+ * run from the HSI. ARMv6-M has no cycle counter, there SysTick runs free
+ * on HCLK / 8 from __early_init until stInit() takes it over at the end
+ * of halInit(). cyclecount_get() starts right there, the stages from
+ * halInit on add the boardInit time kept in boottime_record.offset.
+ */
+
+#ifndef BOOTTIME_ENABLE
+#define BOOTTIME_ENABLE             TRUE
+#endif
+
+/* .ram0 is not cleared by crt0, in contrast to .bss and .ram0_clear. */
+#ifndef BOOTTIME_SECTION
+#define BOOTTIME_SECTION            __attribute__((section(".ram0.noinit")))
+#endif
+
+#define BOOTTIME_MAGIC              0x42544D32U
+
+enum boottime_stage
+{
+    BOOTTIME_RESET,
+    BOOTTIME_CLOCK_INIT,
+    BOOTTIME_BOARD_INIT,
+    BOOTTIME_HAL_INIT,
+    BOOTTIME_KERNEL_INIT,
+    BOOTTIME_BOARD_START,
+    BOOTTIME_MODULES_INIT,
+    BOOTTIME_MODULES_START,
+    BOOTTIME_FIRST_FRAME,
+    BOOTTIME_STAGE_COUNT,
+};
+
+typedef struct
+{
+    uint32_t magic;
+    /* Resets without power loss since the record was created. */
+    uint32_t boots;
+    /* Added to cyclecount_get(), zero where it counts from reset. */
+    uint32_t offset;
+    uint32_t stages[BOOTTIME_STAGE_COUNT];
+} boottime_record_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern boottime_record_t boottime_record;
+extern const char *const boottime_stage_names[BOOTTIME_STAGE_COUNT];
+
+#if BOOTTIME_ENABLE
+/**
+ * @brief   Starts a new record, first thing in __early_init().
+ */
+void boottime_begin(void);
+
+/**
+ * @brief   Stores the end of @p stage.
+ */
+void boottime_mark(enum boottime_stage stage);
+#else
+#define boottime_begin()
+#define boottime_mark(stage)
+#endif /* BOOTTIME_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOOTTIME_H_ */
@@ -0,0 +1,91 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "clockscale.h"
+
+#if CLOCKSCALE_ENABLE
+
+#include <stddef.h>
+
+unsigned clockscale_shift;
+
+#if CH_CFG_ST_TIMEDELTA == 0
+uint32_t clockscale_st_cycles;
+#endif /* CH_CFG_ST_TIMEDELTA == 0 */
+
+static clockscale_listener_t *listeners;
+
+static const uint32_t hpre[] =
+{
+    RCC_CFGR_HPRE_DIV1,
+    RCC_CFGR_HPRE_DIV2,
+    RCC_CFGR_HPRE_DIV4,
+    RCC_CFGR_HPRE_DIV8,
+};
+
+/* Keeps CH_CFG_ST_FREQUENCY, called with the kernel locked. */
+static void clockscale_fix_st(unsigned shift)
+{
+#if CH_CFG_ST_TIMEDELTA == 0
+    /* Writing VAL restarts the tick, the elapsed part of it is lost to the
+     * system time but kept for the cycle counter. */
+    uint32_t elapsed = SysTick->LOAD - SysTick->VAL;
+    clockscale_st_cycles += elapsed << clockscale_shift;
+
+    SysTick->LOAD = ((STM32_HCLK >> shift) / CH_CFG_ST_FREQUENCY) - 1;
+    SysTick->VAL = 0;
+#else
+    /* The prescaler is loaded on an update event only, which would also
+     * clear the counter holding the system time. */
+    uint32_t cnt = TIM2->CNT;
+    TIM2->PSC = ((STM32_TIMCLK1 >> shift) / CH_CFG_ST_FREQUENCY) - 1;
+    TIM2->EGR = TIM_EGR_UG;
+    TIM2->CNT = cnt;
+    TIM2->SR = ~TIM_SR_UIF;
+#endif /* CH_CFG_ST_TIMEDELTA == 0 */
+}
+
+void clockscale_register(clockscale_listener_t *listener)
+{
+    listener->next = listeners;
+    listeners = listener;
+}
+
+void clockscale_set(unsigned shift)
+{
+    chDbgCheck(shift <= CLOCKSCALE_MAX_SHIFT);
+
+    if (shift == clockscale_shift)
+        return;
+
+    for (clockscale_listener_t *l = listeners; l != NULL; l = l->next)
+    {
+        if (l->prepare != NULL)
+            l->prepare(l->arg);
+    }
+
+    chSysLock();
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_HPRE) | hpre[shift];
+    clockscale_fix_st(shift);
+    clockscale_shift = shift;
+    chSysUnlock();
+
+    for (clockscale_listener_t *l = listeners; l != NULL; l = l->next)
+    {
+        if (l->complete != NULL)
+            l->complete(l->arg, shift);
+    }
+}
+
+#endif /* CLOCKSCALE_ENABLE */
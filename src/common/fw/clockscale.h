@@ -0,0 +1,113 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef CLOCKSCALE_H_
+#define CLOCKSCALE_H_
+
+#include "target_cfg.h"
+
+#include "hal.h"
+
+#include <stdint.h>
+
+/*
+ * Runtime clock scaling through the AHB prescaler. The PLL keeps running,
+ * HCLK and with it all bus and timer clocks are divided by 2^shift. The
+ * system timer is corrected here. Drivers with clock derived settings
+ * register a listener, which is called before the change to bring the
+ * peripheral to a halt and afterwards to reprogram it.
+ *
+ * All compile time clock constants, e.g. STM32_HCLK, keep describing
+ * shift 0.
+ */
+
+#ifndef CLOCKSCALE_ENABLE
+#define CLOCKSCALE_ENABLE           FALSE
+#endif
+
+/**
+ * @brief   Largest shift, HCLK is divided by up to 2^CLOCKSCALE_MAX_SHIFT.
+ */
+#ifndef CLOCKSCALE_MAX_SHIFT
+#define CLOCKSCALE_MAX_SHIFT        2
+#endif
+
+#if CLOCKSCALE_ENABLE
+
+#if (CLOCKSCALE_MAX_SHIFT < 1) || (CLOCKSCALE_MAX_SHIFT > 3)
+#error "CLOCKSCALE_MAX_SHIFT out of range"
+#endif
+
+#if (CH_CFG_ST_TIMEDELTA == 0) &&                                           \
+    ((STM32_HCLK % (CH_CFG_ST_FREQUENCY << CLOCKSCALE_MAX_SHIFT)) != 0)
+#error "SysTick cannot keep CH_CFG_ST_FREQUENCY at all clock levels"
+#endif
+
+#if (CH_CFG_ST_TIMEDELTA > 0) && (STM32_ST_USE_TIMER != 2)
+#error "clockscale supports TIM2 as system timer only"
+#endif
+
+#endif /* CLOCKSCALE_ENABLE */
+
+typedef struct clockscale_listener
+{
+    struct clockscale_listener *next;
+    /* Waits until the peripheral is idle, called from thread context.
+     * May be NULL. */
+    void (*prepare)(void *arg);
+    /* Reprograms the peripheral for the new shift. */
+    void (*complete)(void *arg, unsigned shift);
+    void *arg;
+} clockscale_listener_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if CLOCKSCALE_ENABLE
+extern unsigned clockscale_shift;
+#if CH_CFG_ST_TIMEDELTA == 0
+/* Full clock cycles of the ticks cut short by a change, for
+ * cyclecount_get(). */
+extern uint32_t clockscale_st_cycles;
+#endif /* CH_CFG_ST_TIMEDELTA == 0 */
+
+/**
+ * @note    Listeners must be registered before the first change, e.g. from
+ *          static constructors or boardStart().
+ */
+void clockscale_register(clockscale_listener_t *listener);
+
+/**
+ * @brief   Divides HCLK by 2^@p shift.
+ */
+void clockscale_set(unsigned shift);
+
+static inline unsigned clockscale_get_shift(void)
+{
+    return clockscale_shift;
+}
+#else
+static inline unsigned clockscale_get_shift(void)
+{
+    return 0;
+}
+#endif /* CLOCKSCALE_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOCKSCALE_H_ */
@@ -0,0 +1,81 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef CYCLECOUNT_H_
+#define CYCLECOUNT_H_
+
+#include "hal.h"
+#include "clockscale.h"
+
+#include <stdint.h>
+
+/*
+ * Free running core clock cycle counter, wrapping at 32 bit.
+ * ARMv7-M uses the DWT cycle counter. ARMv6-M has none, there the
+ * periodic SysTick is extended by the system time. With clock scaling
+ * the count keeps the rate of STM32_HCLK, so durations do not depend on
+ * the clock they were taken at.
+ */
+
+#if CLOCKSCALE_ENABLE && (CORTEX_MODEL >= 3)
+#error "the DWT counts at the scaled clock, CLOCKSCALE_ENABLE needs ARMv6-M"
+#endif
+
+/* Rate of cyclecount_get() at any clock scale, to convert into time. */
+#define CYCLECOUNT_FREQUENCY        STM32_HCLK
+
+static inline void cyclecount_init(void)
+{
+#if CORTEX_MODEL >= 3
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif /* CORTEX_MODEL >= 3 */
+}
+
+static inline uint32_t cyclecount_get(void)
+{
+#if CORTEX_MODEL >= 3
+    return DWT->CYCCNT;
+#elif CH_CFG_ST_TIMEDELTA == 0
+    syssts_t sts = chSysGetStatusAndLockX();
+    uint32_t reload = SysTick->LOAD + 1U;
+    uint32_t ticks = (uint32_t)chVTGetSystemTimeX();
+    uint32_t val = SysTick->VAL;
+
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0U)
+    {
+        /* SysTick wrapped but the tick has not been processed yet. */
+        ticks++;
+        val = SysTick->VAL;
+    }
+#if CLOCKSCALE_ENABLE
+    /* The SysTick counts HCLK >> shift. */
+    uint32_t cycles = ticks * (STM32_HCLK / CH_CFG_ST_FREQUENCY) +
+            clockscale_st_cycles + ((reload - 1U - val) << clockscale_shift);
+    chSysRestoreStatusX(sts);
+
+    return cycles;
+#else
+    chSysRestoreStatusX(sts);
+
+    return ticks * reload + (reload - 1U - val);
+#endif /* CLOCKSCALE_ENABLE */
+#else
+    /* Tickless mode, only system tick resolution is available. */
+    return (uint32_t)chVTGetSystemTimeX() * (STM32_HCLK / CH_CFG_ST_FREQUENCY);
+#endif
+}
+
+#endif /* CYCLECOUNT_H_ */
@@ -0,0 +1,41 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "idlestat.h"
+
+#include "cyclecount.h"
+
+idlestat_t idlestat;
+
+void idlestat_enter(void)
+{
+    uint32_t now = cyclecount_get();
+
+    idlestat.busy_cycles += now - idlestat.last;
+    idlestat.last = now;
+}
+
+void idlestat_leave(void)
+{
+    uint32_t now = cyclecount_get();
+
+    idlestat.idle_cycles += now - idlestat.last;
+    idlestat.last = now;
+    idlestat.switches++;
+}
+
+void idlestat_wakeup(void)
+{
+    idlestat.wakeups++;
+}
@@ -0,0 +1,58 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef IDLESTAT_H_
+#define IDLESTAT_H_
+
+#include <stdint.h>
+
+/*
+ * Idle statistics, fed by the idle hooks of chconf.h. Counts every return
+ * of the idle thread from port_wait_for_interrupt(), i.e. each wake-up by
+ * an interrupt, and splits the time into idle and busy core cycles. The
+ * idle command of make/gdb/profile.py turns them into a wake-up rate and
+ * a current estimate.
+ *
+ * Included by chconf.h, so it must not include any kernel header.
+ */
+
+typedef struct
+{
+    /* Wake-ups from idle, including interrupts which return to idle. */
+    uint32_t wakeups;
+    /* Times the idle thread was left for another thread. */
+    uint32_t switches;
+    uint64_t idle_cycles;
+    uint64_t busy_cycles;
+    /* cyclecount_get() at the last enter or leave. */
+    uint32_t last;
+} idlestat_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern idlestat_t idlestat;
+
+/* Called from the kernel hooks only, within the critical zone. */
+void idlestat_enter(void);
+void idlestat_leave(void);
+void idlestat_wakeup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IDLESTAT_H_ */
@@ -14,12 +14,54 @@
 
 #include "module_init.h"
 #include "nvm_tools.h"
+#include "startup.h"
+#include "boottime.h"
+#include "msgbus.h"
+#include "standby.h"
 
 #include <stdbool.h>
 #include "target_cfg.h"
 
 BSEMAPHORE_DECL(main_shutdown_sema, true);
 
+#if defined(PARTITION_BL) && defined(PARTITION_BL_UPDATE)
+static bool main_reset_requested = false;
+
+static THD_WORKING_AREA(wa_bl_update, 512);
+
+/*
+ * Check and automagically update bootloader if necessary.
+ * Runs next to the modules at the lowest priority, so comparing the
+ * partitions no longer delays the first frame. The modules are stopped
+ * by main before the reset. It is assumed that erasing and writing will
+ * not take longer than the watchdog period.
+ */
+static THD_FUNCTION(bl_update_thread, arg)
+{
+    (void)arg;
+    NVMDeviceInfo di;
+
+    chRegSetThreadName("bl_update");
+
+    /* Omitting this breaks strict aliasing rule but i don't know why. */
+    BaseNVMDevice* partition_bl_update = PARTITION_BL_UPDATE;
+
+    if (nvmGetInfo(partition_bl_update, &di) == HAL_SUCCESS)
+    {
+        uint32_t n = di.sector_size * di.sector_num;
+        if (nvmcmp(PARTITION_BL_UPDATE, PARTITION_BL, n) != 0)
+        {
+            ledOn(LED_WARNING);
+            nvmMassWriteUnprotect(PARTITION_BL);
+            nvmMassErase(PARTITION_BL);
+            nvmcpy(PARTITION_BL, PARTITION_BL_UPDATE, n);
+            main_reset_requested = true;
+            chBSemSignal(&main_shutdown_sema);
+        }
+    }
+}
+#endif /* defined(PARTITION_BL) && defined(PARTITION_BL_UPDATE) */
+
 /*
  * Application entry point.
  */
@@ -33,46 +75,29 @@ int main(void)
      *   RTOS is active.
      */
     halInit();
+    boottime_mark(BOOTTIME_HAL_INIT);
     chSysInit();
+    boottime_mark(BOOTTIME_KERNEL_INIT);
+
+    msgbus_init();
 
     boardStart();
+    boottime_mark(BOOTTIME_BOARD_START);
 
 #if HAL_USE_LED && !defined(NDEBUG)
     ledOn(LED_STATUS);
 #endif /* HAL_USE_LED && !defined(NDEBUG) */
 
-#if defined(PARTITION_BL) && defined(PARTITION_BL_UPDATE)
-    /*
-     * Check and automagically update bootloader if necessary.
-     * It is assumed that this process will not take longer
-     * than the watchdog period.
-     */
-    {
-        NVMDeviceInfo di;
-
-        /* Omitting this breaks strict aliasing rule but i don't know why. */
-        BaseNVMDevice* partition_bl_update = PARTITION_BL_UPDATE;
-
-        if (nvmGetInfo(partition_bl_update, &di) == HAL_SUCCESS)
-        {
-            uint32_t n = di.sector_size * di.sector_num;
-            if (nvmcmp(PARTITION_BL_UPDATE, PARTITION_BL, n) != 0)
-            {
-                ledOn(LED_WARNING);
-                nvmMassWriteUnprotect(PARTITION_BL);
-                nvmMassErase(PARTITION_BL);
-                nvmcpy(PARTITION_BL, PARTITION_BL_UPDATE, n);
-                boardStop();
-                chSysDisable();
-                boardReset();
-            }
-        }
-    }
-#endif /* defined(PARTITION_BL) && defined(PARTITION_BL_UPDATE) */
-
     MODULE_INITIALISE_ALL();
+    boottime_mark(BOOTTIME_MODULES_INIT);
 
     MODULE_START_ALL();
+    boottime_mark(BOOTTIME_MODULES_START);
+
+#if defined(PARTITION_BL) && defined(PARTITION_BL_UPDATE)
+    chThdCreateStatic(wa_bl_update, sizeof(wa_bl_update), LOWPRIO,
+            bl_update_thread, NULL);
+#endif /* defined(PARTITION_BL) && defined(PARTITION_BL_UPDATE) */
 
     /* Assign ourselves the highest possible priority and wait for the
      * shutdown signal.
@@ -89,5 +114,19 @@ int main(void)
     boardStop();
     chSysDisable();
 
+#if defined(PARTITION_BL) && defined(PARTITION_BL_UPDATE)
+    if (main_reset_requested)
+    {
+        boardReset();
+    }
+#endif /* defined(PARTITION_BL) && defined(PARTITION_BL_UPDATE) */
+
+#if STANDBY_ENABLE
+    if (standby_requested())
+    {
+        boardStandby();
+    }
+#endif /* STANDBY_ENABLE */
+
     chThdExit(0);
 }
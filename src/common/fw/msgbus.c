@@ -0,0 +1,131 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "msgbus.h"
+
+#include "cyclecount.h"
+
+#include <stddef.h>
+
+uint32_t msgbus_dropped;
+
+static msgbus_msg_t msgbus_storage[MSGBUS_POOL_SIZE];
+static MEMORYPOOL_DECL(msgbus_pool, sizeof(msgbus_msg_t), PORT_NATURAL_ALIGN,
+        NULL);
+static EVENTSOURCE_DECL(msgbus_source);
+static msgbus_subscriber_t *msgbus_subscribers;
+
+void msgbus_init(void)
+{
+    chPoolLoadArray(&msgbus_pool, msgbus_storage, MSGBUS_POOL_SIZE);
+}
+
+void msgbus_subscribe(msgbus_subscriber_t *sub, eventflags_t topics,
+        eventmask_t events)
+{
+    sub->topics = topics;
+    chMBObjectInit(&sub->mailbox, sub->buffer, MSGBUS_MAILBOX_SIZE);
+    chEvtRegisterMaskWithFlags(&msgbus_source, &sub->listener, events,
+            topics);
+
+    chSysLock();
+    sub->next = msgbus_subscribers;
+    msgbus_subscribers = sub;
+    chSysUnlock();
+}
+
+void msgbus_unsubscribe(msgbus_subscriber_t *sub)
+{
+    const msgbus_msg_t *msg;
+
+    chSysLock();
+    for (msgbus_subscriber_t **p = &msgbus_subscribers; *p != NULL;
+            p = &(*p)->next)
+    {
+        if (*p == sub)
+        {
+            *p = sub->next;
+            break;
+        }
+    }
+    chSysUnlock();
+
+    chEvtUnregister(&msgbus_source, &sub->listener);
+    while ((msg = msgbus_fetch(sub)) != NULL)
+    {
+        msgbus_release(msg);
+    }
+}
+
+bool msgbus_postI(enum msgbus_topic topic, uint32_t arg)
+{
+    uint32_t timestamp = cyclecount_get();
+    bool delivered = true;
+
+    chDbgCheckClassI();
+
+    for (msgbus_subscriber_t *sub = msgbus_subscribers; sub != NULL;
+            sub = sub->next)
+    {
+        if ((sub->topics & MSGBUS_TOPIC_MASK(topic)) == 0)
+            continue;
+
+        msgbus_msg_t *msg = chPoolAllocI(&msgbus_pool);
+        if (msg == NULL)
+        {
+            msgbus_dropped++;
+            delivered = false;
+            continue;
+        }
+
+        msg->topic = topic;
+        msg->arg = arg;
+        msg->timestamp = timestamp;
+        if (chMBPostI(&sub->mailbox, (msg_t)msg) != MSG_OK)
+        {
+            chPoolFreeI(&msgbus_pool, msg);
+            msgbus_dropped++;
+            delivered = false;
+        }
+    }
+
+    chEvtBroadcastFlagsI(&msgbus_source, MSGBUS_TOPIC_MASK(topic));
+
+    return delivered;
+}
+
+bool msgbus_post(enum msgbus_topic topic, uint32_t arg)
+{
+    chSysLock();
+    bool delivered = msgbus_postI(topic, arg);
+    chSchRescheduleS();
+    chSysUnlock();
+
+    return delivered;
+}
+
+const msgbus_msg_t *msgbus_fetch(msgbus_subscriber_t *sub)
+{
+    msg_t msg;
+
+    if (chMBFetchTimeout(&sub->mailbox, &msg, TIME_IMMEDIATE) != MSG_OK)
+        return NULL;
+
+    return (const msgbus_msg_t *)msg;
+}
+
+void msgbus_release(const msgbus_msg_t *msg)
+{
+    chPoolFree(&msgbus_pool, (void *)msg);
+}
@@ -0,0 +1,111 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef MSGBUS_H_
+#define MSGBUS_H_
+
+#include "ch.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Publish/subscribe between modules, also from ISRs. A message is taken
+ * from a static pool and queued in the mailbox of every subscriber of its
+ * topic, then the topic is broadcast as event flag. Subscribers wake up
+ * right away, fetch their messages and release them to the pool again.
+ * Messages which find no free pool entry or a full mailbox are dropped
+ * and counted in msgbus_dropped.
+ */
+
+/**
+ * @brief   Messages in flight, summed over all subscribers.
+ */
+#ifndef MSGBUS_POOL_SIZE
+#define MSGBUS_POOL_SIZE            8
+#endif
+
+/**
+ * @brief   Messages queued per subscriber.
+ */
+#ifndef MSGBUS_MAILBOX_SIZE
+#define MSGBUS_MAILBOX_SIZE         4
+#endif
+
+#if (CH_CFG_USE_MEMPOOLS != TRUE) || (CH_CFG_USE_MAILBOXES != TRUE)
+#error "msgbus requires CH_CFG_USE_MEMPOOLS and CH_CFG_USE_MAILBOXES"
+#endif
+
+enum msgbus_topic
+{
+    /* Show the next effect, no argument. */
+    MSGBUS_EFFECT_NEXT,
+    MSGBUS_TOPIC_COUNT,
+};
+
+#define MSGBUS_TOPIC_MASK(topic)    ((eventflags_t)1 << (topic))
+
+typedef struct
+{
+    enum msgbus_topic topic;
+    uint32_t arg;
+    /* cyclecount_get() at the time of posting. */
+    uint32_t timestamp;
+} msgbus_msg_t;
+
+typedef struct msgbus_subscriber
+{
+    struct msgbus_subscriber *next;
+    eventflags_t topics;
+    event_listener_t listener;
+    mailbox_t mailbox;
+    msg_t buffer[MSGBUS_MAILBOX_SIZE];
+} msgbus_subscriber_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern uint32_t msgbus_dropped;
+
+void msgbus_init(void);
+
+/**
+ * @brief   Subscribes the calling thread to @p topics.
+ * @param[in] events    Event mask of the thread signalled on new messages.
+ */
+void msgbus_subscribe(msgbus_subscriber_t *sub, eventflags_t topics,
+        eventmask_t events);
+void msgbus_unsubscribe(msgbus_subscriber_t *sub);
+
+/**
+ * @brief   Posts a message to all subscribers of @p topic.
+ * @return              false if at least one subscriber missed it.
+ */
+bool msgbus_post(enum msgbus_topic topic, uint32_t arg);
+bool msgbus_postI(enum msgbus_topic topic, uint32_t arg);
+
+/**
+ * @brief   Returns the next message of @p sub or NULL if there is none.
+ * @note    The message must be passed to msgbus_release() afterwards.
+ */
+const msgbus_msg_t *msgbus_fetch(msgbus_subscriber_t *sub);
+void msgbus_release(const msgbus_msg_t *msg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MSGBUS_H_ */
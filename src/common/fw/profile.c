@@ -0,0 +1,69 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "profile.h"
+
+#if PROFILE_ENABLE
+
+#include "ch.h"
+
+#include <string.h>
+
+profile_stats_t profile_stats[PROFILE_ZONE_COUNT];
+
+const char *const profile_zone_names[PROFILE_ZONE_COUNT] =
+{
+    [PROFILE_DRAW_EFFECTS] = "DrawEffects",
+    [PROFILE_EFFECT_UPDATE] = "EffectUpdate",
+    [PROFILE_WS281X_UPDATE] = "ws281xUpdate",
+    [PROFILE_LIS3DH_DRAIN] = "lis3dh drain",
+    [PROFILE_LIS3DH_TEMP] = "lis3dh temp",
+    [PROFILE_COLOR_ADD_DSP] = "ColorAdd dsp",
+    [PROFILE_COLOR_ADD_PORTABLE] = "ColorAdd port",
+    [PROFILE_COLOR_SCALE_DSP] = "ColorScale dsp",
+    [PROFILE_COLOR_SCALE_PORTABLE] = "ColorScale port",
+    [PROFILE_COLOR_LERP_DSP] = "ColorLerp dsp",
+    [PROFILE_COLOR_LERP_PORTABLE] = "ColorLerp port",
+    [PROFILE_COLOR_CLEAR] = "ColorClear",
+};
+
+void profile_record(enum profile_zone zone, uint32_t duration)
+{
+    uint32_t bin = 0;
+    if (duration > 1)
+        bin = 31 - __builtin_clz(duration);
+    if (bin >= PROFILE_HISTOGRAM_BINS)
+        bin = PROFILE_HISTOGRAM_BINS - 1;
+
+    /* Zones may be shared between threads and interrupts. */
+    syssts_t sts = chSysGetStatusAndLockX();
+    profile_stats_t *stats = &profile_stats[zone];
+    if (stats->count == 0 || duration < stats->min)
+        stats->min = duration;
+    if (duration > stats->max)
+        stats->max = duration;
+    stats->count++;
+    stats->total += duration;
+    stats->histogram[bin]++;
+    chSysRestoreStatusX(sts);
+}
+
+void profile_reset(void)
+{
+    syssts_t sts = chSysGetStatusAndLockX();
+    memset(profile_stats, 0, sizeof(profile_stats));
+    chSysRestoreStatusX(sts);
+}
+
+#endif /* PROFILE_ENABLE */
@@ -0,0 +1,141 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include "target_cfg.h"
+
+#include <stdint.h>
+
+/*
+ * Timing zones on hot paths. Each zone aggregates count, min, max, total
+ * and a log2 histogram of its durations in profile_stats[], which the
+ * profile command of make/gdb/profile.py prints. Durations are core
+ * cycles on the target and nanoseconds in host builds, which define
+ * PROFILE_HOST_CLOCK.
+ */
+
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE              FALSE
+#endif
+
+/* Bin n counts durations of 2^n up to 2^(n+1) - 1, the last one all
+ * longer ones as well. */
+#ifndef PROFILE_HISTOGRAM_BINS
+#define PROFILE_HISTOGRAM_BINS      24
+#endif
+
+enum profile_zone
+{
+    PROFILE_DRAW_EFFECTS,
+    PROFILE_EFFECT_UPDATE,
+    PROFILE_WS281X_UPDATE,
+    PROFILE_LIS3DH_DRAIN,
+    PROFILE_LIS3DH_TEMP,
+    /* DSP and portable color kernels, see ColorKernelsBenchmark(). */
+    PROFILE_COLOR_ADD_DSP,
+    PROFILE_COLOR_ADD_PORTABLE,
+    PROFILE_COLOR_SCALE_DSP,
+    PROFILE_COLOR_SCALE_PORTABLE,
+    PROFILE_COLOR_LERP_DSP,
+    PROFILE_COLOR_LERP_PORTABLE,
+    PROFILE_COLOR_CLEAR,
+    PROFILE_ZONE_COUNT,
+};
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t histogram[PROFILE_HISTOGRAM_BINS];
+} profile_stats_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern profile_stats_t profile_stats[PROFILE_ZONE_COUNT];
+extern const char *const profile_zone_names[PROFILE_ZONE_COUNT];
+
+void profile_record(enum profile_zone zone, uint32_t duration);
+void profile_reset(void);
+
+#if defined(PROFILE_HOST_CLOCK)
+uint32_t profile_host_now(void);
+#endif /* defined(PROFILE_HOST_CLOCK) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#if defined(PROFILE_HOST_CLOCK)
+#define PROFILE_NOW()               profile_host_now()
+#else
+#include "cyclecount.h"
+#define PROFILE_NOW()               cyclecount_get()
+#endif /* defined(PROFILE_HOST_CLOCK) */
+
+/**
+ * @brief   Times the code between the two macros, both in one block.
+ */
+#if PROFILE_ENABLE
+#define PROFILE_BEGIN(zone)         uint32_t profile_start_##zone = PROFILE_NOW()
+#define PROFILE_END(zone)                                                   \
+    profile_record(zone, PROFILE_NOW() - profile_start_##zone)
+#else
+#define PROFILE_BEGIN(zone)
+#define PROFILE_END(zone)
+#endif /* PROFILE_ENABLE */
+
+#ifdef __cplusplus
+
+/**
+ * @brief   Times the rest of the enclosing scope.
+ */
+#if PROFILE_ENABLE
+#define PROFILE_SCOPE(zone)         ProfileScope PROFILE_SCOPE_NAME(__LINE__)(zone)
+#define PROFILE_SCOPE_NAME(line)    PROFILE_SCOPE_NAME2(line)
+#define PROFILE_SCOPE_NAME2(line)   profileScope##line
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(enum profile_zone timed) :
+        zone(timed), start(PROFILE_NOW())
+    {
+    }
+
+    ~ProfileScope()
+    {
+        profile_record(zone, PROFILE_NOW() - start);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    enum profile_zone zone;
+    uint32_t start;
+};
+#else
+#define PROFILE_SCOPE(zone)
+#endif /* PROFILE_ENABLE */
+
+#endif /* __cplusplus */
+
+#endif /* PROFILE_H_ */
@@ -0,0 +1,126 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "snapshot.h"
+
+#include <string.h>
+
+#if SNAPSHOT_ENABLE
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t sequence;
+    uint16_t size;
+    uint16_t checksum;
+} snapshot_header_t;
+
+typedef struct
+{
+    snapshot_header_t header;
+    uint8_t data[SNAPSHOT_SLOT_SIZE];
+} snapshot_copy_t;
+
+/* Sequence of the newest copy per slot, the older one is written next. */
+static uint32_t snapshot_sequence[SNAPSHOT_SLOT_COUNT];
+
+/* Fletcher-16 over the sequence and the data. */
+static uint16_t snapshot_checksum(const snapshot_copy_t *copy)
+{
+    uint16_t a = copy->header.size;
+    uint16_t b = 0;
+    const uint8_t *seq = (const uint8_t *)&copy->header.sequence;
+
+    for (size_t i = 0; i < sizeof(copy->header.sequence); i++)
+    {
+        a = (a + seq[i]) % 255;
+        b = (b + a) % 255;
+    }
+    for (size_t i = 0; i < copy->header.size; i++)
+    {
+        a = (a + copy->data[i]) % 255;
+        b = (b + a) % 255;
+    }
+
+    return (uint16_t)((b << 8) | a);
+}
+
+static uint32_t snapshot_offset(enum snapshot_slot slot, unsigned copy)
+{
+    return ((uint32_t)slot * 2 + copy) * sizeof(snapshot_copy_t);
+}
+
+static bool snapshot_read(enum snapshot_slot slot, unsigned copy,
+        snapshot_copy_t *buffer)
+{
+    if (nvmRead(SNAPSHOT_DEVICE, snapshot_offset(slot, copy),
+            sizeof(*buffer), (uint8_t *)buffer) != HAL_SUCCESS)
+        return false;
+
+    return buffer->header.magic == SNAPSHOT_MAGIC &&
+            buffer->header.size <= SNAPSHOT_SLOT_SIZE &&
+            buffer->header.checksum == snapshot_checksum(buffer);
+}
+
+bool snapshot_load(enum snapshot_slot slot, void *data, size_t size)
+{
+    chDbgCheck(slot < SNAPSHOT_SLOT_COUNT && size <= SNAPSHOT_SLOT_SIZE);
+
+    snapshot_copy_t copies[2];
+    bool valid[2];
+    for (unsigned i = 0; i < 2; i++)
+        valid[i] = snapshot_read(slot, i, &copies[i]);
+
+    /* The newer copy wins, sequences are compared with wrap-around. */
+    unsigned newest = valid[0] ? 0 : 1;
+    if (valid[0] && valid[1] &&
+            (int32_t)(copies[1].header.sequence -
+                    copies[0].header.sequence) > 0)
+        newest = 1;
+
+    if (!valid[newest])
+        return false;
+
+    snapshot_sequence[slot] = copies[newest].header.sequence;
+    if (copies[newest].header.size != size)
+        return false;
+
+    memcpy(data, copies[newest].data, size);
+    return true;
+}
+
+void snapshot_store(enum snapshot_slot slot, const void *data, size_t size)
+{
+    chDbgCheck(slot < SNAPSHOT_SLOT_COUNT && size <= SNAPSHOT_SLOT_SIZE);
+
+    snapshot_copy_t copy = {
+        .header = {
+            .magic = SNAPSHOT_MAGIC,
+            .sequence = snapshot_sequence[slot] + 1,
+            .size = (uint16_t)size,
+            .checksum = 0,
+        },
+        .data = {0},
+    };
+    memcpy(copy.data, data, size);
+    copy.header.checksum = snapshot_checksum(&copy);
+
+    /* Even sequences go to the first copy, odd ones to the second. */
+    nvmWrite(SNAPSHOT_DEVICE,
+            snapshot_offset(slot, copy.header.sequence & 1),
+            sizeof(copy), (const uint8_t *)&copy);
+    snapshot_sequence[slot] = copy.header.sequence;
+}
+
+#endif /* SNAPSHOT_ENABLE */
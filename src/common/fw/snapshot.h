@@ -0,0 +1,81 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include "target_cfg.h"
+
+#include "qhal.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Runtime state kept across resets. Each module owns a slot, stores its
+ * state whenever it changes and loads it again in Init(). A slot holds two
+ * copies written alternately, a reset in the middle of a store leaves the
+ * previous copy intact. Copies failing the checksum, e.g. after a power
+ * loss without backup supply, are ignored.
+ */
+
+#ifndef SNAPSHOT_ENABLE
+#define SNAPSHOT_ENABLE             FALSE
+#endif
+
+/**
+ * @brief   Largest state of one module.
+ */
+#ifndef SNAPSHOT_SLOT_SIZE
+#define SNAPSHOT_SLOT_SIZE          32
+#endif
+
+#define SNAPSHOT_MAGIC              0x534E5031
+
+#if SNAPSHOT_ENABLE && !defined(SNAPSHOT_DEVICE)
+#error "SNAPSHOT_DEVICE must name the BaseNVMDevice keeping the snapshot"
+#endif
+
+enum snapshot_slot
+{
+    SNAPSHOT_MOD_EFFECTS,
+    SNAPSHOT_SLOT_COUNT,
+};
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if SNAPSHOT_ENABLE
+/**
+ * @brief   Fetches the newest valid state of @p slot.
+ * @return              false if there is none of @p size bytes.
+ */
+bool snapshot_load(enum snapshot_slot slot, void *data, size_t size);
+
+/**
+ * @brief   Replaces the older copy of @p slot by @p data.
+ * @note    Only the owner of @p slot may call this, after snapshot_load()
+ *          picked up the sequence.
+ */
+void snapshot_store(enum snapshot_slot slot, const void *data, size_t size);
+#endif /* SNAPSHOT_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SNAPSHOT_H_ */
@@ -0,0 +1,41 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "standby.h"
+
+#if STANDBY_ENABLE
+
+/* Declared in main.c. */
+extern binary_semaphore_t main_shutdown_sema;
+
+static volatile bool standby_pending;
+
+void standby_request(void)
+{
+    chSysLock();
+    if (!standby_pending)
+    {
+        standby_pending = true;
+        chBSemSignalI(&main_shutdown_sema);
+        chSchRescheduleS();
+    }
+    chSysUnlock();
+}
+
+bool standby_requested(void)
+{
+    return standby_pending;
+}
+
+#endif /* STANDBY_ENABLE */
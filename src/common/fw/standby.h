@@ -0,0 +1,54 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STANDBY_H_
+#define STANDBY_H_
+
+#include "target_cfg.h"
+
+#include "ch.h"
+
+#include <stdbool.h>
+
+/*
+ * Low-power standby of an unused unit. A module decides that the unit is
+ * not in use and requests standby, main then stops the modules as for a
+ * reset and calls boardStandby(). Modules arming wake-up sources check
+ * standby_requested() while they shut down.
+ */
+
+#ifndef STANDBY_ENABLE
+#define STANDBY_ENABLE              FALSE
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if STANDBY_ENABLE
+/**
+ * @brief   Stops the modules and enters standby.
+ * @note    Only the first call has an effect.
+ */
+void standby_request(void);
+
+bool standby_requested(void);
+#endif /* STANDBY_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STANDBY_H_ */
@@ -0,0 +1,55 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "startup.h"
+
+#include "cyclecount.h"
+
+uint32_t startup_ready_cycles[STARTUP_MOD_COUNT];
+
+static EVENTSOURCE_DECL(startup_source);
+static eventflags_t startup_ready_mask;
+
+void startup_ready(enum startup_module module)
+{
+    uint32_t cycles = cyclecount_get();
+
+    chSysLock();
+    if ((startup_ready_mask & STARTUP_MASK(module)) == 0)
+    {
+        startup_ready_cycles[module] = cycles;
+        startup_ready_mask |= STARTUP_MASK(module);
+        chEvtBroadcastFlagsI(&startup_source, STARTUP_MASK(module));
+        chSchRescheduleS();
+    }
+    chSysUnlock();
+}
+
+bool startup_wait(eventflags_t modules, sysinterval_t timeout)
+{
+    event_listener_t listener;
+    bool ready;
+
+    /* Registered before the check, so no report can slip through. */
+    chEvtRegisterMaskWithFlags(&startup_source, &listener, STARTUP_EVENT,
+            modules);
+    while (!(ready = (startup_ready_mask & modules) == modules))
+    {
+        if (chEvtWaitAnyTimeout(STARTUP_EVENT, timeout) == 0)
+            break;
+    }
+    chEvtUnregister(&startup_source, &listener);
+
+    return ready;
+}
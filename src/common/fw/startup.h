@@ -0,0 +1,72 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STARTUP_H_
+#define STARTUP_H_
+
+#include "ch.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Module start-up beyond the MODULE_INITCALL levels. Every module thread
+ * sets itself up concurrently and reports when it is ready. A module
+ * depending on another one waits for that report in its own thread
+ * instead of relying on the initcall order, so independent modules are
+ * never held up. The ready times are kept for the debugger.
+ */
+
+enum startup_module
+{
+    STARTUP_MOD_TEST,
+    STARTUP_MOD_EFFECTS,
+    STARTUP_MOD_SENSORS,
+    STARTUP_MOD_LOGGER,
+    STARTUP_MOD_MONITOR,
+    STARTUP_MOD_COUNT,
+};
+
+#define STARTUP_MASK(module)    ((eventflags_t)1 << (module))
+
+/* Event used by startup_wait(), must not be used by the waiting thread
+ * otherwise. */
+#define STARTUP_EVENT           EVENT_MASK(31)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* cyclecount_get() when ready, zero until then. Same time base as
+ * boottime_record without its offset. */
+extern uint32_t startup_ready_cycles[STARTUP_MOD_COUNT];
+
+/**
+ * @brief   Reports @p module as ready, e.g. after its first LED frame.
+ * @note    Only the first call per module is recorded.
+ */
+void startup_ready(enum startup_module module);
+
+/**
+ * @brief   Waits until all modules in @p modules reported ready.
+ * @return              false if the timeout expired before.
+ */
+bool startup_wait(eventflags_t modules, sysinterval_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STARTUP_H_ */
@@ -0,0 +1,38 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "trace.h"
+
+void trace_freeze(void)
+{
+#if TRACE_ENABLED
+    chDbgSuspendTrace(CH_DBG_TRACE_MASK_ALL);
+#endif /* TRACE_ENABLED */
+}
+
+void trace_resume(void)
+{
+#if TRACE_ENABLED
+    chDbgResumeTrace(CH_DBG_TRACE_MASK_ALL);
+#endif /* TRACE_ENABLED */
+}
+
+bool trace_is_frozen(void)
+{
+#if TRACE_ENABLED
+    return ch.dbg.trace_buffer.suspended == CH_DBG_TRACE_MASK_ALL;
+#else
+    return false;
+#endif /* TRACE_ENABLED */
+}
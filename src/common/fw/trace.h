@@ -0,0 +1,65 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "ch.h"
+
+#include <stdbool.h>
+
+/*
+ * Helpers around the kernel trace buffer. The buffer is read by the
+ * chtrace command of make/gdb/chtrace.py, which writes a Chrome trace
+ * event file.
+ */
+
+#define TRACE_ENABLED       (CH_DBG_TRACE_MASK != CH_DBG_TRACE_MASK_DISABLED)
+#define TRACE_USER_ENABLED  (TRACE_ENABLED && \
+                             ((CH_DBG_TRACE_MASK & CH_DBG_TRACE_MASK_USER) != 0))
+
+/* Second argument of the user events, the first one is the name. */
+#define TRACE_USER_BEGIN    1
+#define TRACE_USER_END      2
+
+/**
+ * @brief   Marks the begin and end of a span in the current thread.
+ * @note    @p name must be a string literal, only its address is stored.
+ */
+#if TRACE_USER_ENABLED
+#define TRACE_BEGIN(name)   chDbgWriteTrace((void *)(name), (void *)TRACE_USER_BEGIN)
+#define TRACE_END(name)     chDbgWriteTrace((void *)(name), (void *)TRACE_USER_END)
+#else
+#define TRACE_BEGIN(name)
+#define TRACE_END(name)
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief   Stops recording, the events leading up to this point stay in
+ *          the buffer until a debugger fetched them.
+ */
+void trace_freeze(void);
+void trace_resume(void);
+bool trace_is_frozen(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H_ */
@@ -15,27 +15,92 @@
 #include "watchdog.h"
 
 #include "target_cfg.h"
+#include "hal.h"
 
-#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 
-static uint32_t registered_sources;
+watchdog_record_t watchdog_record WATCHDOG_SECTION;
 
-void watchdog_register(enum watchdog_source source)
-{
-    registered_sources |= (1 << source);
-}
+/* Zero for sources not registered. Written after the reload time, the
+ * check timer may already run. */
+static volatile sysinterval_t deadlines[WATCHDOG_SOURCE_COUNT];
 
-void watchdog_reload(enum watchdog_source source)
+/* Last reload, written by the source only. */
+static volatile systime_t reloads[WATCHDOG_SOURCE_COUNT];
+
+/* Set while a source is overdue, so a starvation is counted once. Like
+ * the record, written by the check timer only. */
+static bool starving[WATCHDOG_SOURCE_COUNT];
+
+static virtual_timer_t check_timer;
+static bool checking;
+
+/* Runs from the timer interrupt outside the kernel lock. */
+static void watchdog_check(void* arg)
 {
-    static uint32_t active_sources;
+    bool healthy = true;
 
-    active_sources |= (1 << source);
+    (void)arg;
 
-    if (active_sources == registered_sources)
+    for (size_t i = 0; i < WATCHDOG_SOURCE_COUNT; ++i)
     {
-        active_sources = 0;
+        if (deadlines[i] == 0)
+            continue;
+
+        systime_t last = reloads[i];
+        sysinterval_t elapsed = chTimeDiffX(last, chVTGetSystemTimeX());
+        if (elapsed <= deadlines[i])
+        {
+            starving[i] = false;
+            continue;
+        }
+
+        if (!starving[i])
+        {
+            starving[i] = true;
+            watchdog_record.missed[i]++;
+        }
+        watchdog_record.last_offender = i;
+        watchdog_record.last_overdue = elapsed - deadlines[i];
+        healthy = false;
+    }
+
+    chSysLockFromISR();
 #if HAL_USE_WDG
-        wdgReset(&WDGD1);
+    if (healthy)
+    {
+        wdgResetI(&WDGD1);
+    }
+#else
+    (void)healthy;
 #endif /* HAL_USE_WDG */
+    chVTSetI(&check_timer, WATCHDOG_CHECK_INTERVAL, watchdog_check, NULL);
+    chSysUnlockFromISR();
+}
+
+/* Called from the Init functions, before any module thread runs. */
+void watchdog_register(enum watchdog_source source, sysinterval_t deadline)
+{
+    if (watchdog_record.magic != WATCHDOG_MAGIC)
+    {
+        memset(&watchdog_record, 0, sizeof(watchdog_record));
+        watchdog_record.magic = WATCHDOG_MAGIC;
+        watchdog_record.last_offender = WATCHDOG_NONE;
+    }
+
+    reloads[source] = chVTGetSystemTimeX();
+    deadlines[source] = deadline;
+
+    if (!checking)
+    {
+        checking = true;
+        chVTObjectInit(&check_timer);
+        chVTSet(&check_timer, WATCHDOG_CHECK_INTERVAL, watchdog_check, NULL);
     }
 }
+
+void watchdog_reload(enum watchdog_source source)
+{
+    reloads[source] = chVTGetSystemTimeX();
+}
@@ -15,25 +15,77 @@
 #ifndef WATCHDOG_H_
 #define WATCHDOG_H_
 
+#include "ch.h"
+
+#include <stdint.h>
+
+/*
+ * Software supervisor in front of the hardware watchdog. Every source
+ * reloads within its own deadline by storing the time in its own slot.
+ * A virtual timer checks all of them every WATCHDOG_CHECK_INTERVAL and
+ * kicks the hardware watchdog only while none is overdue, so a stall is
+ * recorded even if no thread runs anymore. The timer is the only writer
+ * of the record, neither side takes a lock for it.
+ *
+ * A source found overdue is recorded in watchdog_record, which is not
+ * cleared by crt0. After the reset it still names the last offender and
+ * by how much it was late. The watchdog command of make/gdb/watchdog.py
+ * prints it.
+ */
+
+/* .ram0 is not cleared by crt0, in contrast to .bss and .ram0_clear. */
+#ifndef WATCHDOG_SECTION
+#define WATCHDOG_SECTION            __attribute__((section(".ram0.noinit")))
+#endif
+
+#define WATCHDOG_MAGIC              0x57444731U
+
+/* Well inside the shortest deadline and the hardware watchdog period. */
+#ifndef WATCHDOG_CHECK_INTERVAL
+#define WATCHDOG_CHECK_INTERVAL     TIME_MS2I(100)
+#endif
+
 enum watchdog_source
 {
     WATCHDOG_MOD_TEST,
     WATCHDOG_MOD_EFFECTS,
     WATCHDOG_MOD_SENSORS,
+    WATCHDOG_MOD_LOGGER,
+    WATCHDOG_MOD_MONITOR,
+    WATCHDOG_SOURCE_COUNT,
 };
 
+#define WATCHDOG_NONE               0xFFFFFFFFU
+
+typedef struct
+{
+    uint32_t magic;
+    /* Starvations per source, one per missed deadline until it reloads. */
+    uint32_t missed[WATCHDOG_SOURCE_COUNT];
+    /* Source found overdue last, WATCHDOG_NONE if none so far. */
+    uint32_t last_offender;
+    /* Time past its deadline at the last check, in system ticks. */
+    uint32_t last_overdue;
+} watchdog_record_t;
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
-void watchdog_register(enum watchdog_source source);
+extern watchdog_record_t watchdog_record;
+
+/**
+ * @brief   Supervises @p source from now on.
+ * @details The first call starts the check timer.
+ * @param[in] deadline  Longest time allowed between two reloads. Must be
+ *                      well below the hardware watchdog period.
+ */
+void watchdog_register(enum watchdog_source source, sysinterval_t deadline);
 void watchdog_reload(enum watchdog_source source);
 
 #ifdef __cplusplus
 }
 #endif
 
-
-
 #endif /* WATCHDOG_H_ */
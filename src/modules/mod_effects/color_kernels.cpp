@@ -0,0 +1,277 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "color_kernels.hpp"
+
+#if MOD_EFFECTS
+
+#if COLOR_KERNELS_USE_DSP
+#include "qhal.h"
+#endif /* COLOR_KERNELS_USE_DSP */
+
+#if COLOR_KERNELS_BENCHMARK
+#include "profile.h"
+#endif /* COLOR_KERNELS_BENCHMARK */
+
+#include <string.h>
+
+static_assert(sizeof(Color) == 3, "color kernels expect packed RGB pixels");
+
+namespace blinky
+{
+
+/*===========================================================================*/
+/* Local functions                                                           */
+/*===========================================================================*/
+
+#if COLOR_KERNELS_USE_DSP
+/* Pixel arrays are byte aligned, the M4 handles unaligned word access. */
+static inline uint32_t LoadWord(const uint8_t* p)
+{
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+static inline void StoreWord(uint8_t* p, uint32_t w)
+{
+    memcpy(p, &w, sizeof(w));
+}
+
+/* Multiplies the four bytes of w by s (at most 256), keeps the high bytes. */
+static inline uint32_t ScaleWord(uint32_t w, uint32_t s)
+{
+    uint32_t even = __UXTB16(w) * s;
+    uint32_t odd = __UXTB16(__ROR(w, 8)) * s;
+    return ((even >> 8) & 0x00FF00FFu) | (odd & 0xFF00FF00u);
+}
+
+static inline uint32_t LerpWord(uint32_t a, uint32_t b, uint32_t wa,
+        uint32_t wb)
+{
+    /* Each halfword sum stays below 255 * 256, no carry between lanes. */
+    uint32_t even = __UXTB16(a) * wa + __UXTB16(b) * wb;
+    uint32_t odd = __UXTB16(__ROR(a, 8)) * wa + __UXTB16(__ROR(b, 8)) * wb;
+    return ((even >> 8) & 0x00FF00FFu) | (odd & 0xFF00FF00u);
+}
+#endif /* COLOR_KERNELS_USE_DSP */
+
+/*===========================================================================*/
+/* Exported functions                                                        */
+/*===========================================================================*/
+
+namespace portable
+{
+
+void ColorAddSaturate(Color* dst, const Color* src, size_t count)
+{
+    uint8_t* d = reinterpret_cast<uint8_t*>(dst);
+    const uint8_t* s = reinterpret_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < count * sizeof(Color); ++i)
+    {
+        uint16_t sum = d[i] + s[i];
+        d[i] = (sum > 0xFF) ? 0xFF : sum;
+    }
+}
+
+void ColorScale(Color* dst, size_t count, uint8_t factor)
+{
+    uint8_t* d = reinterpret_cast<uint8_t*>(dst);
+    const uint16_t s = factor + 1;
+    for (size_t i = 0; i < count * sizeof(Color); ++i)
+    {
+        d[i] = (d[i] * s) >> 8;
+    }
+}
+
+void ColorLerp(Color* dst, const Color* a, const Color* b, size_t count,
+        uint8_t t)
+{
+    uint8_t* d = reinterpret_cast<uint8_t*>(dst);
+    const uint8_t* pa = reinterpret_cast<const uint8_t*>(a);
+    const uint8_t* pb = reinterpret_cast<const uint8_t*>(b);
+    const uint16_t wa = 256 - t;
+    const uint16_t wb = t;
+    for (size_t i = 0; i < count * sizeof(Color); ++i)
+    {
+        d[i] = (pa[i] * wa + pb[i] * wb) >> 8;
+    }
+}
+
+void ColorClear(Color* dst, size_t count)
+{
+    memset(dst, 0, count * sizeof(Color));
+}
+
+} // namespace portable
+
+#if COLOR_KERNELS_USE_DSP
+
+void ColorAddSaturate(Color* dst, const Color* src, size_t count)
+{
+    uint8_t* d = reinterpret_cast<uint8_t*>(dst);
+    const uint8_t* s = reinterpret_cast<const uint8_t*>(src);
+    size_t n = count * sizeof(Color);
+
+    for (; n >= 4; n -= 4, d += 4, s += 4)
+    {
+        StoreWord(d, __UQADD8(LoadWord(d), LoadWord(s)));
+    }
+
+    for (; n > 0; --n, ++d, ++s)
+    {
+        uint16_t sum = *d + *s;
+        *d = (sum > 0xFF) ? 0xFF : sum;
+    }
+}
+
+void ColorScale(Color* dst, size_t count, uint8_t factor)
+{
+    uint8_t* d = reinterpret_cast<uint8_t*>(dst);
+    size_t n = count * sizeof(Color);
+    const uint32_t s = factor + 1;
+
+    if (factor == 0xFF)
+        return;
+
+    for (; n >= 4; n -= 4, d += 4)
+    {
+        StoreWord(d, ScaleWord(LoadWord(d), s));
+    }
+
+    for (; n > 0; --n, ++d)
+    {
+        *d = (*d * s) >> 8;
+    }
+}
+
+void ColorLerp(Color* dst, const Color* a, const Color* b, size_t count,
+        uint8_t t)
+{
+    uint8_t* d = reinterpret_cast<uint8_t*>(dst);
+    const uint8_t* pa = reinterpret_cast<const uint8_t*>(a);
+    const uint8_t* pb = reinterpret_cast<const uint8_t*>(b);
+    size_t n = count * sizeof(Color);
+    const uint32_t wa = 256 - t;
+    const uint32_t wb = t;
+
+    for (; n >= 4; n -= 4, d += 4, pa += 4, pb += 4)
+    {
+        StoreWord(d, LerpWord(LoadWord(pa), LoadWord(pb), wa, wb));
+    }
+
+    for (; n > 0; --n, ++d, ++pa, ++pb)
+    {
+        *d = (*pa * wa + *pb * wb) >> 8;
+    }
+}
+
+void ColorClear(Color* dst, size_t count)
+{
+    portable::ColorClear(dst, count);
+}
+
+#else /* !COLOR_KERNELS_USE_DSP */
+
+void ColorAddSaturate(Color* dst, const Color* src, size_t count)
+{
+    portable::ColorAddSaturate(dst, src, count);
+}
+
+void ColorScale(Color* dst, size_t count, uint8_t factor)
+{
+    portable::ColorScale(dst, count, factor);
+}
+
+void ColorLerp(Color* dst, const Color* a, const Color* b, size_t count,
+        uint8_t t)
+{
+    portable::ColorLerp(dst, a, b, count, t);
+}
+
+void ColorClear(Color* dst, size_t count)
+{
+    portable::ColorClear(dst, count);
+}
+
+#endif /* COLOR_KERNELS_USE_DSP */
+
+#if COLOR_KERNELS_BENCHMARK
+/* Odd, so the scalar tails after the packed words run as well. */
+#define BENCHMARK_PIXELS    61
+#define BENCHMARK_ROUNDS    64
+
+static Color benchmarkA[BENCHMARK_PIXELS];
+static Color benchmarkB[BENCHMARK_PIXELS];
+static Color benchmarkDst[BENCHMARK_PIXELS];
+
+/* Each kernel starts from the same pixels, only the call is timed. */
+template <typename Kernel>
+static void BenchmarkKernel(enum profile_zone zone, Kernel kernel)
+{
+    memcpy(benchmarkDst, benchmarkB, sizeof(benchmarkDst));
+    uint32_t start = PROFILE_NOW();
+    kernel();
+    profile_record(zone, PROFILE_NOW() - start);
+}
+
+void ColorKernelsBenchmark()
+{
+    uint8_t* a = reinterpret_cast<uint8_t*>(benchmarkA);
+    uint8_t* b = reinterpret_cast<uint8_t*>(benchmarkB);
+    uint32_t seed = 0x1234567;
+    for (size_t i = 0; i < sizeof(benchmarkA); ++i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        a[i] = seed >> 24;
+        b[i] = seed >> 16;
+    }
+
+    for (uint32_t round = 0; round < BENCHMARK_ROUNDS; ++round)
+    {
+        /* Factors 1..253, 255 takes the shortcut of ColorScale. */
+        uint8_t f = 1 + round * 4;
+
+        BenchmarkKernel(PROFILE_COLOR_ADD_DSP, [] {
+            ColorAddSaturate(benchmarkDst, benchmarkA, BENCHMARK_PIXELS);
+        });
+        BenchmarkKernel(PROFILE_COLOR_ADD_PORTABLE, [] {
+            portable::ColorAddSaturate(benchmarkDst, benchmarkA,
+                    BENCHMARK_PIXELS);
+        });
+        BenchmarkKernel(PROFILE_COLOR_SCALE_DSP, [f] {
+            ColorScale(benchmarkDst, BENCHMARK_PIXELS, f);
+        });
+        BenchmarkKernel(PROFILE_COLOR_SCALE_PORTABLE, [f] {
+            portable::ColorScale(benchmarkDst, BENCHMARK_PIXELS, f);
+        });
+        BenchmarkKernel(PROFILE_COLOR_LERP_DSP, [f] {
+            ColorLerp(benchmarkDst, benchmarkA, benchmarkB, BENCHMARK_PIXELS,
+                    f);
+        });
+        BenchmarkKernel(PROFILE_COLOR_LERP_PORTABLE, [f] {
+            portable::ColorLerp(benchmarkDst, benchmarkA, benchmarkB,
+                    BENCHMARK_PIXELS, f);
+        });
+        /* Both builds clear with memset. */
+        BenchmarkKernel(PROFILE_COLOR_CLEAR, [] {
+            ColorClear(benchmarkDst, BENCHMARK_PIXELS);
+        });
+    }
+}
+#endif /* COLOR_KERNELS_BENCHMARK */
+
+} // namespace blinky
+
+#endif /* MOD_EFFECTS */
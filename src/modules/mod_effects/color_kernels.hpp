@@ -0,0 +1,116 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef COLOR_KERNELS_HPP
+#define COLOR_KERNELS_HPP
+
+#include "target_cfg.h"
+
+#if MOD_EFFECTS
+
+#include "color.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*===========================================================================*/
+/* Derived constants and error checks                                        */
+/*===========================================================================*/
+
+/**
+ * @brief   Kernels use the ARMv7E-M packed SIMD instructions when available.
+ * @note    The unit test forces them on and models the instructions.
+ */
+#if !defined(COLOR_KERNELS_USE_DSP)
+#if defined(__ARM_FEATURE_DSP)
+#define COLOR_KERNELS_USE_DSP TRUE
+#else
+#define COLOR_KERNELS_USE_DSP FALSE
+#endif
+#endif
+
+/**
+ * @brief   Times the DSP against the portable kernels once at start-up,
+ *          into the profiling zones of profile.h.
+ * @note    The F407 firmware sets it with make KERNELBENCH=1.
+ */
+#if !defined(COLOR_KERNELS_BENCHMARK)
+#define COLOR_KERNELS_BENCHMARK FALSE
+#endif
+
+#if COLOR_KERNELS_BENCHMARK && !COLOR_KERNELS_USE_DSP
+#error "COLOR_KERNELS_BENCHMARK requires COLOR_KERNELS_USE_DSP"
+#endif
+
+#if COLOR_KERNELS_BENCHMARK && !PROFILE_ENABLE
+#error "COLOR_KERNELS_BENCHMARK requires PROFILE_ENABLE"
+#endif
+
+namespace blinky
+{
+
+/*
+ * All kernels treat the pixels as one byte stream, so they do not care
+ * about channel order. Results are bit exact between the DSP and the
+ * portable implementation.
+ */
+
+/**
+ * @brief   dst = min(dst + src, 255) per channel.
+ */
+void ColorAddSaturate(Color* dst, const Color* src, size_t count);
+
+/**
+ * @brief   dst = dst * (factor + 1) / 256 per channel.
+ * @note    A factor of 255 leaves the pixels untouched.
+ */
+void ColorScale(Color* dst, size_t count, uint8_t factor);
+
+/**
+ * @brief   dst = (a * (256 - t) + b * t) / 256 per channel.
+ * @note    t = 0 yields @p a exactly.
+ */
+void ColorLerp(Color* dst, const Color* a, const Color* b, size_t count,
+        uint8_t t);
+
+/**
+ * @brief   Sets all pixels to black.
+ */
+void ColorClear(Color* dst, size_t count);
+
+/**
+ * @brief   Scalar reference implementation, also used on ARMv6-M.
+ */
+namespace portable
+{
+void ColorAddSaturate(Color* dst, const Color* src, size_t count);
+void ColorScale(Color* dst, size_t count, uint8_t factor);
+void ColorLerp(Color* dst, const Color* a, const Color* b, size_t count,
+        uint8_t t);
+void ColorClear(Color* dst, size_t count);
+} // namespace portable
+
+#if COLOR_KERNELS_BENCHMARK
+/**
+ * @brief   Runs every kernel in both implementations on the same pixels,
+ *          the profile command of make/gdb/profile.py prints the zones.
+ */
+void ColorKernelsBenchmark();
+#endif /* COLOR_KERNELS_BENCHMARK */
+
+} // namespace blinky
+
+#endif /* MOD_EFFECTS */
+
+#endif /* COLOR_KERNELS_HPP */
@@ -10,8 +10,15 @@
 
 #if MOD_EFFECTS
 
+#include "color_kernels.hpp"
+#include "cyclecount.h"
+#include "trace.h"
+#include "profile.h"
+#include "startup.h"
+#include "boottime.h"
 #include "ch_tools.h"
 #include "watchdog.h"
+#include "snapshot.h"
 #include "module_init_cpp.h"
 
 #include "qhal.h"
@@ -24,7 +31,7 @@
 namespace blinky
 {
 template <>
-ModuleEffects ModuleEffectsSingelton::instance = blinky::ModuleEffects();
+ModuleEffects ModuleEffectsSingelton::instance MOD_EFFECTS_SECTION = blinky::ModuleEffects();
 
 
 /**
@@ -33,15 +40,18 @@ ModuleEffects ModuleEffectsSingelton::instance = blinky::ModuleEffects();
 
 void ModuleEffects::Init()
 {
-    watchdog_register(WATCHDOG_MOD_EFFECTS);
+    watchdog_register(WATCHDOG_MOD_EFFECTS, MOD_EFFECTS_WATCHDOG_DEADLINE);
+
+#if SNAPSHOT_ENABLE
+    resumed = LoadSnapshot();
+#endif /* SNAPSHOT_ENABLE */
 }
 
 void ModuleEffects::Start() {
     BaseClass::Start();
 
     // start timer
-    chVTSet(&effTimer, TIME_MS2I(30), ModuleEffects::TimerCallback,
-        reinterpret_cast<void*>(this));
+    ArmSwitch(switchDelay);
 }
 
 void ModuleEffects::Shutdown() {
@@ -50,48 +60,259 @@ void ModuleEffects::Shutdown() {
 
 void ModuleEffects::ThreadMain() {
     chRegSetThreadName("effects");
-    uint8_t effectId = 0;
+    bool firstFrame = true;
+#if COLOR_KERNELS_BENCHMARK
+    // a few ms, before the first frame
+    ColorKernelsBenchmark();
+#endif /* COLOR_KERNELS_BENCHMARK */
+#if SNAPSHOT_ENABLE
+    lastSnapshot = chibios_rt::System::getTime();
+    if (resumed) {
+        // continue where the previous run was reset
+        ResetEffect(lastSnapshot);
+    }
+#endif /* SNAPSHOT_ENABLE */
+    msgbus_subscribe(&busSubscriber, MSGBUS_TOPIC_MASK(MSGBUS_EFFECT_NEXT),
+        EVENT_MASK(1));
+#if MOD_SENSORS
+    motionChannel.Subscribe(&motionCursor);
+    chEvtRegisterMask(motionChannel.GetEventSource(), &motionListener,
+        EVENT_MASK(0));
+#endif /* MOD_SENSORS */
     while (!chThdShouldTerminateX()) {
         watchdog_reload(WATCHDOG_MOD_EFFECTS);
         systime_t current = chibios_rt::System::getTime();
-        if (switchEffect == true) {
-            switchEffect = false;
-
-            ++effectId;
-            if (effectId > 1) {
-                effectId = 0;
+#if MOD_SENSORS
+        bool motion = false;
+        uint32_t motionTimestamp = 0;
+        const MotionSample* samples;
+        size_t count;
+        while ((count = motionChannel.Peek(&motionCursor, &samples)) > 0) {
+            for (size_t i = 0; i < count; ++i) {
+                ApplyMotion(samples[i], current);
             }
+            motion = true;
+            motionTimestamp = samples[count - 1].timestamp;
+            thermal.Feed(samples[count - 1].temperature);
+            motionChannel.Consume(&motionCursor, count);
+        }
 
-            switch (effectId) {
-                case 0:
-                {
-                    effCurrent = &effRandomPixel;
-                }break;
-                case 1:
-                {
-                    effCurrent = &effWandering;
-                    ColorRandom(&effColorCfg.color);
-                    effWanderingCfg.dir = 1 - effWanderingCfg.dir;
-                    effWanderingCfg.turn = !effWanderingCfg.turn;
-                }
-                break;
+        eventflags_t gestures = chEvtGetAndClearFlags(&motionListener);
+        if (gestures & MotionChannel::MOTION_CHANNEL_DOUBLE_TAP) {
+            msgbus_post(MSGBUS_EFFECT_NEXT, 0);
+        }
+        thermal.Update(current);
+#endif /* MOD_SENSORS */
+        bool switchEffect = false;
+        const msgbus_msg_t* msg;
+        while ((msg = msgbus_fetch(&busSubscriber)) != nullptr) {
+            if (msg->topic == MSGBUS_EFFECT_NEXT) {
+                switchEffect = true;
+#if !defined(NDEBUG)
+                switchLatencyLast = cyclecount_get() - msg->timestamp;
+                switchLatencyWorst = std::max(switchLatencyWorst,
+                    switchLatencyLast);
+#endif /* !defined(NDEBUG) */
             }
+            msgbus_release(msg);
+        }
 
-            EffectReset(effCurrent, 0, 0, current);
-
-            // start timer
-            chVTSet(&effTimer, TIME_S2I(30), ModuleEffects::TimerCallback,
-                reinterpret_cast<void*>(this));
+        if (switchEffect == true) {
+            SwitchEffect(current);
+        }
+#if SNAPSHOT_ENABLE
+        if (switchEffect == true ||
+            chTimeDiffX(lastSnapshot, current) >= MOD_EFFECTS_SNAPSHOT_INTERVAL) {
+            StoreSnapshot();
         }
+#endif /* SNAPSHOT_ENABLE */
 
+#if CLOCKSCALE_ENABLE
+        // between frames, the LEDs are idle
+        ScaleClock(frameCycles);
+#endif /* CLOCKSCALE_ENABLE */
         DrawEffects(current);
-        chibios_rt::BaseThread::sleep(TIME_MS2I(10));
+        if (firstFrame) {
+            firstFrame = false;
+            boottime_mark(BOOTTIME_FIRST_FRAME);
+            startup_ready(STARTUP_MOD_EFFECTS);
+        }
+#if MOD_SENSORS
+#if !defined(NDEBUG)
+        if (motion) {
+            motionLatencyLast = cyclecount_get() - motionTimestamp;
+            motionLatencyWorst = std::max(motionLatencyWorst, motionLatencyLast);
+        }
+#endif /* !defined(NDEBUG) */
+
+        // a new sample or message renders the next frame right away
+        chEvtWaitAnyTimeout(EVENT_MASK(0) | EVENT_MASK(1), TIME_MS2I(10));
+#else
+        chEvtWaitAnyTimeout(EVENT_MASK(1), TIME_MS2I(10));
+#endif /* MOD_SENSORS */
+    }
+#if MOD_SENSORS
+    chEvtUnregister(motionChannel.GetEventSource(), &motionListener);
+#endif /* MOD_SENSORS */
+    msgbus_unsubscribe(&busSubscriber);
+#if SNAPSHOT_ENABLE
+    StoreSnapshot();
+#endif /* SNAPSHOT_ENABLE */
+
+#if HAL_USE_WS281X
+    // the LEDs keep the last frame otherwise, e.g. in standby
+    for (std::int32_t idx = 0; idx < LEDCOUNT; ++idx) {
+        ws281xSetColor(&ws281x, idx, 0, 0, 0);
     }
+    ws281xUpdate(&ws281x);
+#endif /* HAL_USE_WS281X */
+}
+
+void ModuleEffects::SwitchEffect(systime_t current) {
+    ++effectId;
+    if (effectId >= EFFECT_COUNT) {
+        effectId = 0;
+    }
+
+    switch (effectId) {
+        case 0:
+        {
+            effCurrent = &effRandomPixel;
+        }break;
+        case 1:
+        {
+            effCurrent = &effWandering;
+            ColorRandom(&effColorCfg.color);
+            effWanderingCfg.dir = 1 - effWanderingCfg.dir;
+            effWanderingCfg.turn = !effWanderingCfg.turn;
+        }
+        break;
+#if MOD_EFFECTS_TEXT_ENABLE
+        case EFFECT_TEXT:
+        {
+            ColorRandom(&effText.color);
+        }
+        break;
+#endif /* MOD_EFFECTS_TEXT_ENABLE */
+    }
+
+    ResetEffect(current);
+
+    // start timer
+    ArmSwitch(MOD_EFFECTS_SWITCH_INTERVAL);
 }
 
+void ModuleEffects::ResetEffect(systime_t current) {
+#if MOD_EFFECTS_TEXT_ENABLE
+    if (effectId == EFFECT_TEXT) {
+#if SNAPSHOT_ENABLE
+        effText.Reset(current, textResumed);
+        textResumed = 0;
+#else
+        effText.Reset(current);
+#endif /* SNAPSHOT_ENABLE */
+        return;
+    }
+#endif /* MOD_EFFECTS_TEXT_ENABLE */
+    EffectReset(effCurrent, 0, 0, current);
+}
+
+void ModuleEffects::ArmSwitch(sysinterval_t delay) {
+    switchArmed = chibios_rt::System::getTime();
+    switchDelay = delay;
+    chVTSet(&effTimer, delay, ModuleEffects::TimerCallback,
+        reinterpret_cast<void*>(this));
+}
+
+#if SNAPSHOT_ENABLE
+bool ModuleEffects::LoadSnapshot() {
+    Snapshot snapshot;
+    if (!snapshot_load(SNAPSHOT_MOD_EFFECTS, &snapshot, sizeof(snapshot)) ||
+        snapshot.effectId >= EFFECT_COUNT) {
+        return false;
+    }
+
+    effectId = snapshot.effectId;
+    effCurrent = (effectId == 1) ? &effWandering : &effRandomPixel;
+    effWanderingCfg.dir = snapshot.wanderingDir;
+    effWanderingCfg.turn = (snapshot.wanderingTurn != 0);
+    effColorCfg.color.R = snapshot.colorR;
+    effColorCfg.color.G = snapshot.colorG;
+    effColorCfg.color.B = snapshot.colorB;
+#if MOD_EFFECTS_TEXT_ENABLE
+    effText.color.R = snapshot.textR;
+    effText.color.G = snapshot.textG;
+    effText.color.B = snapshot.textB;
+    if (effectId == EFFECT_TEXT) {
+        textResumed = TIME_MS2I(snapshot.textScrolledMs);
+    }
+#endif /* MOD_EFFECTS_TEXT_ENABLE */
+#if MOD_SENSORS
+    thermal.SetBrightness(snapshot.brightness);
+#endif /* MOD_SENSORS */
+    switchDelay = std::max(TIME_MS2I(snapshot.switchLeftMs), TIME_MS2I(1));
+    return true;
+}
+
+void ModuleEffects::StoreSnapshot() {
+    // not the frame time, the switch may have been armed after it
+    systime_t now = chibios_rt::System::getTime();
+    sysinterval_t elapsed = chTimeDiffX(switchArmed, now);
+    Snapshot snapshot = {
+        .switchLeftMs = (elapsed < switchDelay) ?
+            (uint32_t)TIME_I2MS(switchDelay - elapsed) : 0,
+        .effectId = effectId,
+        .wanderingDir = (uint8_t)effWanderingCfg.dir,
+        .wanderingTurn = effWanderingCfg.turn,
+#if MOD_SENSORS
+        .brightness = thermal.GetBrightness(),
+#else
+        .brightness = 255,
+#endif /* MOD_SENSORS */
+        .colorR = effColorCfg.color.R,
+        .colorG = effColorCfg.color.G,
+        .colorB = effColorCfg.color.B,
+#if MOD_EFFECTS_TEXT_ENABLE
+        .textScrolledMs = (uint32_t)TIME_I2MS(effText.GetScrolled(now)),
+        .textR = effText.color.R,
+        .textG = effText.color.G,
+        .textB = effText.color.B,
+#endif /* MOD_EFFECTS_TEXT_ENABLE */
+    };
+    snapshot_store(SNAPSHOT_MOD_EFFECTS, &snapshot, sizeof(snapshot));
+    lastSnapshot = now;
+}
+#endif /* SNAPSHOT_ENABLE */
+
+#if MOD_SENSORS
+void ModuleEffects::ApplyMotion(const MotionSample& sample, systime_t current) {
+    // tilt, the wandering light follows the lower end
+    if (sample.x > MOD_EFFECTS_TILT_THRESHOLD) {
+        effWanderingCfg.dir = 0;
+    } else if (sample.x < -MOD_EFFECTS_TILT_THRESHOLD) {
+        effWanderingCfg.dir = 1;
+    }
+
+    // shake, reduce to 1/1024 g so the squares fit
+    std::int32_t x = sample.linearX >> 4;
+    std::int32_t y = sample.linearY >> 4;
+    std::int32_t z = sample.linearZ >> 4;
+    if ((x * x + y * y + z * z) > MOD_EFFECTS_SHAKE_THRESHOLD &&
+        chTimeDiffX(lastShake, current) > MOD_EFFECTS_SHAKE_HOLDOFF) {
+        lastShake = current;
+        msgbus_post(MSGBUS_EFFECT_NEXT, 0);
+    }
+}
+#endif /* MOD_SENSORS */
+
 void ModuleEffects::DrawEffects(systime_t current) {
-    
-    std::for_each(begin(displayPixel), end(displayPixel), [](auto& color) {color = {0,0,0};});
+    PROFILE_SCOPE(PROFILE_DRAW_EFFECTS);
+#if !defined(NDEBUG) || CLOCKSCALE_ENABLE
+    uint32_t renderStart = cyclecount_get();
+#endif /* !defined(NDEBUG) || CLOCKSCALE_ENABLE */
+    TRACE_BEGIN("render");
+
+    ColorClear(displayPixel.data(), displayPixel.size());
 
     DisplayBuffer display =
     {
@@ -100,7 +321,25 @@ void ModuleEffects::DrawEffects(systime_t current) {
         .pixels = displayPixel.data(),
     };
 
+    PROFILE_BEGIN(PROFILE_EFFECT_UPDATE);
+#if MOD_EFFECTS_TEXT_ENABLE
+    if (effectId == EFFECT_TEXT) {
+        effText.Update(current, &display);
+    } else {
+        EffectUpdate(effCurrent, 0, 0, current, &display);
+    }
+#else
     EffectUpdate(effCurrent, 0, 0, current, &display);
+#endif /* MOD_EFFECTS_TEXT_ENABLE */
+    PROFILE_END(PROFILE_EFFECT_UPDATE);
+
+#if MOD_SENSORS
+    // thermal derating acts on the finished frame
+    uint8_t brightness = thermal.GetBrightness();
+    if (brightness < 255) {
+        ColorScale(displayPixel.data(), displayPixel.size(), brightness);
+    }
+#endif /* MOD_SENSORS */
 
     
 #if HAL_USE_WS281X
@@ -108,14 +347,61 @@ void ModuleEffects::DrawEffects(systime_t current) {
     for (auto const& pixel:  displayPixel) {
         ws281xSetColor(&ws281x, idx++, pixel.R, pixel.G, pixel.B);
     }
+#endif /* HAL_USE_WS281X */
+
+    TRACE_END("render");
+#if CLOCKSCALE_ENABLE
+    frameCycles = cyclecount_get() - renderStart;
+#endif /* CLOCKSCALE_ENABLE */
+#if !defined(NDEBUG)
+    renderCyclesLast = cyclecount_get() - renderStart;
+    renderCyclesWorst = std::max(renderCyclesWorst, renderCyclesLast);
+#endif /* !defined(NDEBUG) */
 
+#if HAL_USE_WS281X
+    TRACE_BEGIN("ws281x");
+    PROFILE_BEGIN(PROFILE_WS281X_UPDATE);
     ws281xUpdate(&ws281x);
+    PROFILE_END(PROFILE_WS281X_UPDATE);
+    TRACE_END("ws281x");
 #endif /* HAL_USE_WS281X */
 }
 
+#if CLOCKSCALE_ENABLE
+void ModuleEffects::ScaleClock(uint32_t cycles) {
+    // cycles count at full clock whatever the shift, a frame is due
+    // every 10 ms
+    unsigned shift = clockscale_get_shift();
+    uint32_t budget = STM32_HCLK / 100;
+    uint32_t load = (uint64_t)cycles * 1000 / budget;
+
+    if (load > MOD_EFFECTS_CLOCK_RAISE && shift > 0) {
+        clockscale_set(shift - 1);
+        windowLoad = 0;
+        windowFrames = 0;
+        return;
+    }
+
+    windowLoad = std::max(windowLoad, load);
+    if (++windowFrames < MOD_EFFECTS_CLOCK_WINDOW) {
+        return;
+    }
+
+    if ((windowLoad * 2) < MOD_EFFECTS_CLOCK_LOWER &&
+        shift < CLOCKSCALE_MAX_SHIFT) {
+        clockscale_set(shift + 1);
+    }
+    windowLoad = 0;
+    windowFrames = 0;
+}
+#endif /* CLOCKSCALE_ENABLE */
+
 void ModuleEffects::TimerCallback(void* arg) {
-    auto mod = reinterpret_cast<ModuleEffects*>(arg);
-    mod->switchEffect = true;
+    (void)arg;
+
+    chSysLockFromISR();
+    msgbus_postI(MSGBUS_EFFECT_NEXT, 0);
+    chSysUnlockFromISR();
 }
 
 }  // namespace blinky
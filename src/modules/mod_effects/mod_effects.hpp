@@ -18,10 +18,20 @@
 
 #include "color.h"
 #include "display.h"
+#include "msgbus.h"
 
 #include "effect_randompixels.h"
 #include "effect_wandering.h"
 #include "effect_simplecolor.h"
+#include "text_scroller.hpp"
+
+#if MOD_SENSORS
+#include "motion_channel.hpp"
+#include "thermal_limiter.hpp"
+#endif /* MOD_SENSORS */
+
+#include "clockscale.h"
+#include "snapshot.h"
 
 #include <array>
 
@@ -38,6 +48,64 @@
 #define MOD_EFFECTS_THREADPRIO LOWPRIO
 #endif
 
+/* Placement of the module instance, e.g. a faster RAM bank. */
+#ifndef MOD_EFFECTS_SECTION
+#define MOD_EFFECTS_SECTION
+#endif
+
+/* Attributes of the render path, e.g. to execute it from RAM. */
+#ifndef MOD_EFFECTS_RAMTEXT
+#define MOD_EFFECTS_RAMTEXT
+#endif
+
+/* Longest time between two frames before the watchdog reports us. */
+#ifndef MOD_EFFECTS_WATCHDOG_DEADLINE
+#define MOD_EFFECTS_WATCHDOG_DEADLINE TIME_MS2I(500)
+#endif
+
+/* Render load in permille of the 10 ms frame above which the clock is
+ * raised one step at once. */
+#ifndef MOD_EFFECTS_CLOCK_RAISE
+#define MOD_EFFECTS_CLOCK_RAISE 500
+#endif
+
+/* The clock is lowered one step if the highest load of a window stays
+ * below this at half the clock. */
+#ifndef MOD_EFFECTS_CLOCK_LOWER
+#define MOD_EFFECTS_CLOCK_LOWER 200
+#endif
+
+/* Frames observed before the clock is lowered. */
+#ifndef MOD_EFFECTS_CLOCK_WINDOW
+#define MOD_EFFECTS_CLOCK_WINDOW 100
+#endif
+
+/* Time between two effect switches. */
+#ifndef MOD_EFFECTS_SWITCH_INTERVAL
+#define MOD_EFFECTS_SWITCH_INTERVAL TIME_S2I(30)
+#endif
+
+/* Largest age of the snapshot after a reset the effect was not switched
+ * in, bounds how far the switch timer jumps back. */
+#ifndef MOD_EFFECTS_SNAPSHOT_INTERVAL
+#define MOD_EFFECTS_SNAPSHOT_INTERVAL TIME_MS2I(1000)
+#endif
+
+/* Tilt along x which turns the wandering light, 0.25 g in raw counts. */
+#ifndef MOD_EFFECTS_TILT_THRESHOLD
+#define MOD_EFFECTS_TILT_THRESHOLD 4096
+#endif
+
+/* Squared acceleration without gravity in 1/1024 g above which a shake is
+ * detected, 0.75 g. */
+#ifndef MOD_EFFECTS_SHAKE_THRESHOLD
+#define MOD_EFFECTS_SHAKE_THRESHOLD (768 * 768)
+#endif
+
+#ifndef MOD_EFFECTS_SHAKE_HOLDOFF
+#define MOD_EFFECTS_SHAKE_HOLDOFF TIME_MS2I(1000)
+#endif
+
 #ifndef LEDCOUNT
 #error "LEDCOUNT driver must be specified for this target"
 #endif
@@ -50,6 +118,12 @@
 #error "DISPLAY_HEIGHT driver must be specified for this target"
 #endif
 
+/* The text effect joins the rotation on displays showing the whole font,
+ * a single row would only show a cut through the glyphs. */
+#ifndef MOD_EFFECTS_TEXT_ENABLE
+#define MOD_EFFECTS_TEXT_ENABLE (DISPLAY_HEIGHT >= FONT3X5_HEIGHT)
+#endif
+
 namespace blinky
 {
 /**
@@ -73,10 +147,73 @@ protected:
     tprio_t GetThreadPrio() const override {return MOD_EFFECTS_THREADPRIO;}
 
 private:
-    void DrawEffects(systime_t current);
+    MOD_EFFECTS_RAMTEXT void DrawEffects(systime_t current);
+    void SwitchEffect(systime_t current);
+    void ResetEffect(systime_t current);
+    void ArmSwitch(sysinterval_t delay);
     static void TimerCallback(void* arg);
+#if SNAPSHOT_ENABLE
+    /* State resumed after a reset, in the snapshot slot of the module. */
+    struct Snapshot
+    {
+        uint32_t switchLeftMs;
+        uint8_t effectId;
+        uint8_t wanderingDir;
+        uint8_t wanderingTurn;
+        uint8_t brightness;
+        uint8_t colorR;
+        uint8_t colorG;
+        uint8_t colorB;
+#if MOD_EFFECTS_TEXT_ENABLE
+        uint32_t textScrolledMs;
+        uint8_t textR;
+        uint8_t textG;
+        uint8_t textB;
+#endif /* MOD_EFFECTS_TEXT_ENABLE */
+    };
 
-    bool switchEffect = false;
+    bool LoadSnapshot();
+    void StoreSnapshot();
+
+    bool resumed = false;
+    systime_t lastSnapshot = 0;
+#if MOD_EFFECTS_TEXT_ENABLE
+    /* Scroll position the text continues from after the reset. */
+    sysinterval_t textResumed = 0;
+#endif /* MOD_EFFECTS_TEXT_ENABLE */
+#endif /* SNAPSHOT_ENABLE */
+#if CLOCKSCALE_ENABLE
+    void ScaleClock(uint32_t cycles);
+
+    /* Core cycles of the last render and the window maximum. */
+    uint32_t frameCycles = 0;
+    uint32_t windowLoad = 0;
+    uint32_t windowFrames = 0;
+#endif /* CLOCKSCALE_ENABLE */
+#if MOD_SENSORS
+    void ApplyMotion(const MotionSample& sample, systime_t current);
+
+    event_listener_t motionListener;
+    MotionChannel::Cursor motionCursor;
+    systime_t lastShake = 0;
+    ThermalLimiter thermal;
+#endif /* MOD_SENSORS */
+
+    msgbus_subscriber_t busSubscriber;
+
+#if MOD_EFFECTS_TEXT_ENABLE
+    /* Ids of effectId, the text is drawn by the module and not a tmb_effects
+     * Effect, effCurrent is not used while it is shown. */
+    static const uint8_t EFFECT_TEXT = 2;
+    static const uint8_t EFFECT_COUNT = 3;
+#else
+    static const uint8_t EFFECT_COUNT = 2;
+#endif /* MOD_EFFECTS_TEXT_ENABLE */
+
+    uint8_t effectId = 0;
+    /* The pending switch of effTimer. */
+    systime_t switchArmed = 0;
+    sysinterval_t switchDelay = TIME_MS2I(30);
 
     std::array<Color, LEDCOUNT> displayPixel;
 
@@ -138,7 +275,25 @@ private:
 
     Effect* effCurrent = &effRandomPixel;
 
+#if MOD_EFFECTS_TEXT_ENABLE
+    TextScroller effText;
+#endif /* MOD_EFFECTS_TEXT_ENABLE */
+
     virtual_timer_t effTimer;
+
+#if !defined(NDEBUG)
+    /* Core cycles to render one frame without the LED transfer. */
+    uint32_t renderCyclesLast = 0;
+    uint32_t renderCyclesWorst = 0;
+    /* Core cycles from posting MSGBUS_EFFECT_NEXT until the switch. */
+    uint32_t switchLatencyLast = 0;
+    uint32_t switchLatencyWorst = 0;
+#if MOD_SENSORS
+    /* Core cycles from the sensor read until the frame was sent. */
+    uint32_t motionLatencyLast = 0;
+    uint32_t motionLatencyWorst = 0;
+#endif /* MOD_SENSORS */
+#endif /* !defined(NDEBUG) */
 };
 
 typedef qos::Singleton<ModuleEffects> ModuleEffectsSingelton;
@@ -0,0 +1,293 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "sprite.hpp"
+
+#if MOD_EFFECTS
+
+#include <algorithm>
+
+namespace blinky
+{
+
+/*===========================================================================*/
+/* Local variables                                                           */
+/*===========================================================================*/
+
+static const uint8_t font3x5_bitmap[] =
+{
+    0x00, 0x00, 0x00, /* ' ' */
+    0x00, 0x17, 0x00, /* '!' */
+    0x03, 0x00, 0x03, /* '"' */
+    0x1f, 0x0a, 0x1f, /* '#' */
+    0x12, 0x1f, 0x09, /* '$' */
+    0x09, 0x04, 0x12, /* '%' */
+    0x0a, 0x15, 0x1a, /* '&' */
+    0x00, 0x03, 0x00, /* ''' */
+    0x00, 0x0e, 0x11, /* '(' */
+    0x11, 0x0e, 0x00, /* ')' */
+    0x0a, 0x04, 0x0a, /* '*' */
+    0x04, 0x0e, 0x04, /* '+' */
+    0x10, 0x08, 0x00, /* ',' */
+    0x04, 0x04, 0x04, /* '-' */
+    0x00, 0x10, 0x00, /* '.' */
+    0x18, 0x04, 0x03, /* '/' */
+    0x1f, 0x11, 0x1f, /* '0' */
+    0x12, 0x1f, 0x10, /* '1' */
+    0x1d, 0x15, 0x17, /* '2' */
+    0x11, 0x15, 0x1f, /* '3' */
+    0x07, 0x04, 0x1f, /* '4' */
+    0x17, 0x15, 0x1d, /* '5' */
+    0x1f, 0x15, 0x1d, /* '6' */
+    0x01, 0x1d, 0x03, /* '7' */
+    0x1f, 0x15, 0x1f, /* '8' */
+    0x17, 0x15, 0x1f, /* '9' */
+    0x00, 0x0a, 0x00, /* ':' */
+    0x10, 0x0a, 0x00, /* ';' */
+    0x04, 0x0a, 0x11, /* '<' */
+    0x0a, 0x0a, 0x0a, /* '=' */
+    0x11, 0x0a, 0x04, /* '>' */
+    0x01, 0x15, 0x07, /* '?' */
+    0x0e, 0x15, 0x16, /* '@' */
+    0x1e, 0x05, 0x1e, /* 'A' */
+    0x1f, 0x15, 0x0a, /* 'B' */
+    0x0e, 0x11, 0x11, /* 'C' */
+    0x1f, 0x11, 0x0e, /* 'D' */
+    0x1f, 0x15, 0x11, /* 'E' */
+    0x1f, 0x05, 0x01, /* 'F' */
+    0x0e, 0x11, 0x1d, /* 'G' */
+    0x1f, 0x04, 0x1f, /* 'H' */
+    0x11, 0x1f, 0x11, /* 'I' */
+    0x08, 0x10, 0x0f, /* 'J' */
+    0x1f, 0x04, 0x1b, /* 'K' */
+    0x1f, 0x10, 0x10, /* 'L' */
+    0x1f, 0x06, 0x1f, /* 'M' */
+    0x1f, 0x01, 0x1e, /* 'N' */
+    0x0e, 0x11, 0x0e, /* 'O' */
+    0x1f, 0x05, 0x02, /* 'P' */
+    0x0e, 0x19, 0x16, /* 'Q' */
+    0x1f, 0x05, 0x1a, /* 'R' */
+    0x12, 0x15, 0x09, /* 'S' */
+    0x01, 0x1f, 0x01, /* 'T' */
+    0x1f, 0x10, 0x1f, /* 'U' */
+    0x0f, 0x10, 0x0f, /* 'V' */
+    0x1f, 0x0c, 0x1f, /* 'W' */
+    0x1b, 0x04, 0x1b, /* 'X' */
+    0x03, 0x1c, 0x03, /* 'Y' */
+    0x19, 0x15, 0x13, /* 'Z' */
+};
+
+/*===========================================================================*/
+/* Exported variables                                                        */
+/*===========================================================================*/
+
+const Font font3x5 =
+{
+    3,                  /* width */
+    FONT3X5_HEIGHT,     /* height */
+    1,                  /* spacing */
+    ' ',                /* first */
+    'Z',                /* last */
+    font3x5_bitmap,     /* bitmap */
+};
+
+/*===========================================================================*/
+/* Local functions                                                           */
+/*===========================================================================*/
+
+static bool ColorEqual(const Color& a, const Color& b)
+{
+    return a.R == b.R && a.G == b.G && a.B == b.B;
+}
+
+/**
+ * @brief   Intersects a w x h rectangle at (x, y) with the display.
+ * @return  false if nothing is visible, otherwise the visible part in
+ *          sprite local coordinates [x0, x1) x [y0, y1).
+ */
+static bool Clip(const DisplayBuffer* display, int16_t x, int16_t y,
+        int16_t w, int16_t h, int16_t* x0, int16_t* x1, int16_t* y0,
+        int16_t* y1)
+{
+    *x0 = std::max<int16_t>(0, -x);
+    *y0 = std::max<int16_t>(0, -y);
+    *x1 = std::min<int16_t>(w, static_cast<int16_t>(display->width) - x);
+    *y1 = std::min<int16_t>(h, static_cast<int16_t>(display->height) - y);
+    return (*x0 < *x1) && (*y0 < *y1);
+}
+
+/*===========================================================================*/
+/* Exported functions                                                        */
+/*===========================================================================*/
+
+const GlyphCache::Entry* GlyphCache::Lookup(const Font& font, char glyph,
+        const Color& fg, const Color& bg)
+{
+    if (glyph < font.first || glyph > font.last ||
+        font.width > MOD_EFFECTS_GLYPH_MAX_WIDTH ||
+        font.height > MOD_EFFECTS_GLYPH_MAX_HEIGHT)
+    {
+        return nullptr;
+    }
+
+    ++clock;
+
+    Entry* victim = &entries[0];
+    for (auto& entry : entries)
+    {
+        if (entry.font == &font && entry.glyph == glyph &&
+            ColorEqual(entry.fg, fg) && ColorEqual(entry.bg, bg))
+        {
+            entry.used = clock;
+            return &entry;
+        }
+
+        /* Unused entries have font == nullptr and win automatically. */
+        if (victim->font != nullptr &&
+            (entry.font == nullptr ||
+             static_cast<uint16_t>(clock - entry.used) >
+             static_cast<uint16_t>(clock - victim->used)))
+        {
+            victim = &entry;
+        }
+    }
+
+    /* Expand the glyph once, later blits only copy rows. */
+    const uint8_t* columns = &font.bitmap[(glyph - font.first) * font.width];
+    for (uint8_t row = 0; row < font.height; ++row)
+    {
+        for (uint8_t col = 0; col < font.width; ++col)
+        {
+            victim->pixels[row][col] = (columns[col] & (1 << row)) ? fg : bg;
+        }
+    }
+
+    victim->font = &font;
+    victim->glyph = glyph;
+    victim->fg = fg;
+    victim->bg = bg;
+    victim->used = clock;
+    return victim;
+}
+
+void GlyphCache::Flush()
+{
+    for (auto& entry : entries)
+    {
+        entry.font = nullptr;
+    }
+}
+
+/**
+ * @brief   Draws a sprite with clipping.
+ * @note    Mono sprites are drawn in @p color, unset bits are transparent.
+ *          Palette sprites ignore @p color.
+ */
+void SpriteBlit(DisplayBuffer* display, int16_t x, int16_t y,
+        const Sprite& sprite, const Color& color)
+{
+    int16_t x0, x1, y0, y1;
+    if (!Clip(display, x, y, sprite.width, sprite.height, &x0, &x1, &y0, &y1))
+        return;
+
+    const int16_t stride = static_cast<int16_t>(display->width);
+    const int16_t rowBytes = (sprite.width + 7) / 8;
+
+    for (int16_t row = y0; row < y1; ++row)
+    {
+        Color* dst = &display->pixels[(y + row) * stride + x];
+
+        if (sprite.format == SpriteFormat::Mono)
+        {
+            const uint8_t* src = &sprite.data[row * rowBytes];
+            for (int16_t col = x0; col < x1; ++col)
+            {
+                if (src[col / 8] & (0x80 >> (col % 8)))
+                    dst[col] = color;
+            }
+        }
+        else
+        {
+            const uint8_t* src = &sprite.data[row * sprite.width];
+            for (int16_t col = x0; col < x1; ++col)
+            {
+                if (src[col] != 0)
+                    dst[col] = sprite.palette[src[col]];
+            }
+        }
+    }
+}
+
+/**
+ * @brief   Copies a cached glyph into the display, clipped.
+ * @note    Glyphs are opaque, their background color is drawn as well.
+ */
+void FontBlitGlyph(DisplayBuffer* display, int16_t x, int16_t y,
+        const Font& font, const GlyphCache::Entry& glyph)
+{
+    int16_t x0, x1, y0, y1;
+    if (!Clip(display, x, y, font.width, font.height, &x0, &x1, &y0, &y1))
+        return;
+
+    const int16_t stride = static_cast<int16_t>(display->width);
+
+    for (int16_t row = y0; row < y1; ++row)
+    {
+        std::copy(&glyph.pixels[row][x0], &glyph.pixels[row][x1],
+                &display->pixels[(y + row) * stride + x + x0]);
+    }
+}
+
+int16_t FontTextWidth(const Font& font, const char* text)
+{
+    int16_t width = 0;
+    for (; *text != '\0'; ++text)
+    {
+        width += font.width + font.spacing;
+    }
+    return width;
+}
+
+/**
+ * @brief   Draws a string starting at (x, y).
+ * @details Glyphs left of the display are skipped without touching the
+ *          cache and drawing stops at the right edge, so a scroller can
+ *          pass an ever decreasing @p x every frame.
+ * @return  x position following the last glyph.
+ */
+int16_t FontDrawText(DisplayBuffer* display, int16_t x, int16_t y,
+        const Font& font, const char* text, const Color& fg,
+        const Color& bg, GlyphCache* cache)
+{
+    const int16_t advance = font.width + font.spacing;
+
+    for (; *text != '\0'; ++text, x += advance)
+    {
+        if (x + font.width <= 0)
+            continue;
+
+        if (x >= static_cast<int16_t>(display->width))
+            return x + FontTextWidth(font, text);
+
+        const GlyphCache::Entry* glyph = cache->Lookup(font, *text, fg, bg);
+        if (glyph != nullptr)
+            FontBlitGlyph(display, x, y, font, *glyph);
+    }
+
+    return x;
+}
+
+} // namespace blinky
+
+#endif /* MOD_EFFECTS */
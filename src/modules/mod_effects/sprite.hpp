@@ -0,0 +1,152 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SPRITE_HPP
+#define SPRITE_HPP
+
+#include "target_cfg.h"
+
+#if MOD_EFFECTS
+
+#include "color.h"
+#include "display.h"
+
+#include <array>
+#include <cstdint>
+
+/*===========================================================================*/
+/* Pre-compile time settings                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of pre-expanded glyphs kept in a @p GlyphCache.
+ */
+#ifndef MOD_EFFECTS_GLYPH_CACHE_SIZE
+#define MOD_EFFECTS_GLYPH_CACHE_SIZE 4
+#endif
+
+/**
+ * @brief   Largest glyph a @p GlyphCache entry can hold.
+ * @note    Glyph columns are stored as one byte, so the height is at most 8.
+ */
+#ifndef MOD_EFFECTS_GLYPH_MAX_WIDTH
+#define MOD_EFFECTS_GLYPH_MAX_WIDTH 5
+#endif
+
+#ifndef MOD_EFFECTS_GLYPH_MAX_HEIGHT
+#define MOD_EFFECTS_GLYPH_MAX_HEIGHT 8
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks                                        */
+/*===========================================================================*/
+
+#if MOD_EFFECTS_GLYPH_MAX_HEIGHT > 8
+#error "MOD_EFFECTS_GLYPH_MAX_HEIGHT must not exceed 8"
+#endif
+
+namespace blinky
+{
+
+/**
+ * @brief   Pixel encoding of a @p Sprite.
+ */
+enum class SpriteFormat : uint8_t
+{
+    /* One bit per pixel, rows MSB first, padded to full bytes. */
+    Mono,
+    /* One palette index per pixel, index 0 is transparent. */
+    Palette,
+};
+
+/**
+ * @brief   Constant sprite image, usually placed in flash.
+ */
+struct Sprite
+{
+    uint8_t width;
+    uint8_t height;
+    SpriteFormat format;
+    const uint8_t* data;
+    const Color* palette;
+};
+
+/**
+ * @brief   Flash resident fixed width bitmap font.
+ * @details Glyphs are stored column by column, one byte per column with
+ *          bit 0 being the top row. Glyph @p first starts at bitmap[0],
+ *          every glyph occupies @p width bytes.
+ */
+struct Font
+{
+    uint8_t width;
+    uint8_t height;
+    uint8_t spacing;
+    char first;
+    char last;
+    const uint8_t* bitmap;
+};
+
+/**
+ * @brief   Built-in 3x5 font covering ' ' to 'Z'.
+ */
+extern const Font font3x5;
+
+/* Rows of font3x5, for compile time checks. */
+#define FONT3X5_HEIGHT 5
+
+/**
+ * @brief   Small LRU cache of glyphs expanded to their final colors.
+ * @details Drawing a cached glyph is a plain copy of each visible row
+ *          segment instead of a bit test per pixel.
+ */
+class GlyphCache
+{
+public:
+    struct Entry
+    {
+        const Font* font;
+        char glyph;
+        Color fg;
+        Color bg;
+        uint16_t used;
+        Color pixels[MOD_EFFECTS_GLYPH_MAX_HEIGHT][MOD_EFFECTS_GLYPH_MAX_WIDTH];
+    };
+
+    const Entry* Lookup(const Font& font, char glyph, const Color& fg,
+            const Color& bg);
+    void Flush();
+
+private:
+    std::array<Entry, MOD_EFFECTS_GLYPH_CACHE_SIZE> entries = {};
+    uint16_t clock = 0;
+};
+
+void SpriteBlit(DisplayBuffer* display, int16_t x, int16_t y,
+        const Sprite& sprite, const Color& color);
+
+void FontBlitGlyph(DisplayBuffer* display, int16_t x, int16_t y,
+        const Font& font, const GlyphCache::Entry& glyph);
+
+int16_t FontTextWidth(const Font& font, const char* text);
+
+int16_t FontDrawText(DisplayBuffer* display, int16_t x, int16_t y,
+        const Font& font, const char* text, const Color& fg,
+        const Color& bg, GlyphCache* cache);
+
+} // namespace blinky
+
+#endif /* MOD_EFFECTS */
+
+#endif /* SPRITE_HPP */
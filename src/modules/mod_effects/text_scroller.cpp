@@ -0,0 +1,49 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "text_scroller.hpp"
+
+#if MOD_EFFECTS
+
+namespace blinky
+{
+
+/*===========================================================================*/
+/* Exported functions                                                        */
+/*===========================================================================*/
+
+void TextScroller::Reset(systime_t now, sysinterval_t scrolled)
+{
+    start = chTimeSubtractX(now, scrolled);
+}
+
+void TextScroller::Update(systime_t now, DisplayBuffer* display)
+{
+    static const Color background = {0x00, 0x00, 0x00};
+    const int16_t width = static_cast<int16_t>(display->width);
+    const int16_t height = static_cast<int16_t>(display->height);
+    const int16_t length = FontTextWidth(font3x5, MOD_EFFECTS_TEXT);
+
+    /* One pass runs from the right edge until the text has left. */
+    uint32_t column = chTimeDiffX(start, now) / MOD_EFFECTS_TEXT_SPEED;
+    int16_t x = width - static_cast<int16_t>(column % (width + length));
+    int16_t y = (height - font3x5.height) / 2;
+
+    FontDrawText(display, x, y, font3x5, MOD_EFFECTS_TEXT, color,
+            background, &cache);
+}
+
+} // namespace blinky
+
+#endif /* MOD_EFFECTS */
@@ -0,0 +1,82 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef TEXT_SCROLLER_HPP
+#define TEXT_SCROLLER_HPP
+
+#include "target_cfg.h"
+
+#if MOD_EFFECTS
+
+#include "sprite.hpp"
+
+#include "qhal.h"
+
+#include <cstdint>
+
+/*===========================================================================*/
+/* Pre-compile time settings                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Text shown by the scroller effect.
+ * @note    font3x5 has upper case letters only.
+ */
+#ifndef MOD_EFFECTS_TEXT
+#define MOD_EFFECTS_TEXT "B-1NKY"
+#endif
+
+/**
+ * @brief   Time the text needs to move by one column.
+ */
+#ifndef MOD_EFFECTS_TEXT_SPEED
+#define MOD_EFFECTS_TEXT_SPEED TIME_MS2I(150)
+#endif
+
+namespace blinky
+{
+
+/**
+ * @brief   Scrolls a line of text from right to left through the display.
+ * @details The text is centered vertically, displays lower than the font
+ *          show the middle rows of the glyphs. Once it has left the
+ *          display it enters again from the right.
+ */
+class TextScroller
+{
+public:
+    /**
+     * @brief   Starts the text @p scrolled into its pass, e.g. the time
+     *          returned by GetScrolled() before a reset.
+     */
+    void Reset(systime_t now, sysinterval_t scrolled = 0);
+    void Update(systime_t now, DisplayBuffer* display);
+
+    sysinterval_t GetScrolled(systime_t now) const
+    {
+        return chTimeDiffX(start, now);
+    }
+
+    Color color = {0xFF, 0xFF, 0xFF};
+
+private:
+    systime_t start = 0;
+    GlyphCache cache;
+};
+
+} // namespace blinky
+
+#endif /* MOD_EFFECTS */
+
+#endif /* TEXT_SCROLLER_HPP */
@@ -0,0 +1,78 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "thermal_limiter.hpp"
+
+#if MOD_EFFECTS
+
+/*===========================================================================*/
+/* Local definitions                                                         */
+/*===========================================================================*/
+
+/* Weight of a new reading is 1/8, about eight intervals to settle. */
+#define FILTER_SHIFT                3
+
+#define DERATE_START    ((MOD_EFFECTS_DERATE_START - MOD_EFFECTS_TEMP_OFFSET) * 256)
+#define DERATE_END      ((MOD_EFFECTS_DERATE_END - MOD_EFFECTS_TEMP_OFFSET) * 256)
+
+namespace blinky
+{
+
+/*===========================================================================*/
+/* Exported functions                                                        */
+/*===========================================================================*/
+
+void ThermalLimiter::Update(systime_t now)
+{
+    if (!valid)
+        return;
+
+    if (!primed)
+    {
+        filtered = latest;
+        lastUpdate = now;
+        primed = true;
+    }
+    else if (chTimeDiffX(lastUpdate, now) >= MOD_EFFECTS_DERATE_INTERVAL)
+    {
+        filtered += (latest - filtered) >> FILTER_SHIFT;
+        lastUpdate = now;
+    }
+    else
+    {
+        return;
+    }
+
+    int32_t target = 255;
+    if (filtered >= DERATE_END)
+    {
+        target = MOD_EFFECTS_DERATE_MIN;
+    }
+    else if (filtered > DERATE_START)
+    {
+        target = 255 - (255 - MOD_EFFECTS_DERATE_MIN) *
+                (filtered - DERATE_START) / (DERATE_END - DERATE_START);
+    }
+
+    int32_t step = target - brightness;
+    if (step > MOD_EFFECTS_DERATE_STEP)
+        step = MOD_EFFECTS_DERATE_STEP;
+    if (step < -MOD_EFFECTS_DERATE_STEP)
+        step = -MOD_EFFECTS_DERATE_STEP;
+    brightness += step;
+}
+
+} // namespace blinky
+
+#endif /* MOD_EFFECTS */
@@ -0,0 +1,146 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef THERMAL_LIMITER_HPP
+#define THERMAL_LIMITER_HPP
+
+#include "target_cfg.h"
+
+#if MOD_EFFECTS
+
+#include "qhal.h"
+
+#include <cstdint>
+
+/*===========================================================================*/
+/* Pre-compile time settings                                                 */
+/*===========================================================================*/
+
+/*
+ * Temperatures are in degrees Celsius. The LIS3DH sensor only tracks
+ * changes at one count per degree, the offset is not trimmed.
+ */
+
+/**
+ * @brief   Temperature at a sensor reading of zero.
+ */
+#ifndef MOD_EFFECTS_TEMP_OFFSET
+#define MOD_EFFECTS_TEMP_OFFSET 25
+#endif
+
+/**
+ * @brief   Temperature above which the brightness is reduced.
+ */
+#ifndef MOD_EFFECTS_DERATE_START
+#define MOD_EFFECTS_DERATE_START 45
+#endif
+
+/**
+ * @brief   Temperature at which MOD_EFFECTS_DERATE_MIN is reached.
+ */
+#ifndef MOD_EFFECTS_DERATE_END
+#define MOD_EFFECTS_DERATE_END 60
+#endif
+
+/**
+ * @brief   Lowest brightness factor, 255 is full brightness.
+ */
+#ifndef MOD_EFFECTS_DERATE_MIN
+#define MOD_EFFECTS_DERATE_MIN 64
+#endif
+
+/**
+ * @brief   Interval of the control loop.
+ */
+#ifndef MOD_EFFECTS_DERATE_INTERVAL
+#define MOD_EFFECTS_DERATE_INTERVAL TIME_MS2I(1000)
+#endif
+
+/**
+ * @brief   Largest brightness change per interval.
+ * @note    Keeps the LEDs from visibly stepping while the enclosure heats.
+ */
+#ifndef MOD_EFFECTS_DERATE_STEP
+#define MOD_EFFECTS_DERATE_STEP 4
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks                                        */
+/*===========================================================================*/
+
+#if MOD_EFFECTS_DERATE_END <= MOD_EFFECTS_DERATE_START
+#error "MOD_EFFECTS_DERATE_END must be above MOD_EFFECTS_DERATE_START"
+#endif
+
+#if (MOD_EFFECTS_DERATE_MIN < 1) || (MOD_EFFECTS_DERATE_MIN > 255)
+#error "MOD_EFFECTS_DERATE_MIN out of range"
+#endif
+
+namespace blinky
+{
+
+/**
+ * @brief   Caps the LED brightness while the enclosure is hot.
+ * @details The temperature is smoothed over several intervals and mapped
+ *          linearly to a brightness factor for ColorScale(), which then
+ *          follows at MOD_EFFECTS_DERATE_STEP per interval.
+ */
+class ThermalLimiter
+{
+public:
+    /**
+     * @brief   Takes a reading as returned by lis3dhReadTemp().
+     */
+    void Feed(int16_t reading)
+    {
+        latest = reading;
+        valid = true;
+    }
+
+    /**
+     * @brief   Runs the control loop, call once per frame.
+     */
+    void Update(systime_t now);
+
+    /**
+     * @brief   Brightness factor, 255 leaves the frame untouched.
+     */
+    uint8_t GetBrightness() const
+    {
+        return brightness;
+    }
+
+    /**
+     * @brief   Continues from a brightness saved before a reset.
+     */
+    void SetBrightness(uint8_t value)
+    {
+        brightness = value;
+    }
+
+private:
+    int16_t latest = 0;
+    bool valid = false;
+    bool primed = false;
+    /* Reading in 1/256 degree above MOD_EFFECTS_TEMP_OFFSET. */
+    int32_t filtered = 0;
+    systime_t lastUpdate = 0;
+    uint8_t brightness = 255;
+};
+
+} // namespace blinky
+
+#endif /* MOD_EFFECTS */
+
+#endif /* THERMAL_LIMITER_HPP */
@@ -0,0 +1,119 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "fat12_format.hpp"
+
+#if MOD_LOGGER
+
+#include <cstring>
+
+namespace blinky
+{
+
+/*===========================================================================*/
+/* Local definitions                                                         */
+/*===========================================================================*/
+
+static const uint32_t RESERVED_SECTORS = 1;
+static const uint32_t ROOT_SECTORS = 1;
+/* Directory entries are 32 bytes. */
+static const uint32_t ROOT_ENTRIES = ROOT_SECTORS * FAT12_SECTOR_SIZE / 32;
+static const uint8_t MEDIA_FIXED = 0xF8;
+
+/*===========================================================================*/
+/* Local functions                                                           */
+/*===========================================================================*/
+
+static void StoreLe16(uint8_t* p, uint32_t value)
+{
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+}
+
+/* Boot sector with the BIOS parameter block, see the Microsoft FAT
+ * specification for the offsets. */
+static void FillBootSector(uint8_t* buffer, uint32_t sectors,
+        uint32_t fatSectors)
+{
+    static const uint8_t jump[] = {0xEB, 0x3C, 0x90};
+
+    memcpy(&buffer[0], jump, sizeof(jump));
+    memcpy(&buffer[3], "MSWIN4.1", 8);
+    StoreLe16(&buffer[11], FAT12_SECTOR_SIZE);
+    buffer[13] = 1;
+    StoreLe16(&buffer[14], RESERVED_SECTORS);
+    buffer[16] = 1;
+    StoreLe16(&buffer[17], ROOT_ENTRIES);
+    StoreLe16(&buffer[19], sectors);
+    buffer[21] = MEDIA_FIXED;
+    StoreLe16(&buffer[22], fatSectors);
+    StoreLe16(&buffer[24], 1);
+    StoreLe16(&buffer[26], 1);
+    buffer[36] = 0x80;
+    buffer[38] = 0x29;
+    memcpy(&buffer[43], "NO NAME    ", 11);
+    memcpy(&buffer[54], "FAT12   ", 8);
+    buffer[510] = 0x55;
+    buffer[511] = 0xAA;
+}
+
+/*===========================================================================*/
+/* Exported functions                                                        */
+/*===========================================================================*/
+
+Fat12Format::Fat12Format(uint32_t volumeSectors) : sectors(volumeSectors)
+{
+    /* Every FAT sector takes the place of a cluster, grow the FAT until
+       it covers the clusters left. */
+    uint32_t fat = 1;
+    while (sectors > RESERVED_SECTORS + fat + ROOT_SECTORS)
+    {
+        uint32_t clusters = sectors - RESERVED_SECTORS - fat - ROOT_SECTORS;
+        /* 12 bit entries, including the two reserved ones. */
+        uint32_t bytes = ((clusters + 2) * 3 + 1) / 2;
+        uint32_t needed = (bytes + FAT12_SECTOR_SIZE - 1) / FAT12_SECTOR_SIZE;
+        if (needed <= fat)
+        {
+            if (clusters <= FAT12_MAX_CLUSTERS)
+            {
+                fatSectors = fat;
+                systemSectors = RESERVED_SECTORS + fat + ROOT_SECTORS;
+            }
+            return;
+        }
+        fat = needed;
+    }
+}
+
+void Fat12Format::FillSector(uint32_t sector, uint8_t* buffer) const
+{
+    memset(buffer, 0, FAT12_SECTOR_SIZE);
+
+    if (sector == 0)
+    {
+        FillBootSector(buffer, sectors, fatSectors);
+    }
+    else if (sector == RESERVED_SECTORS)
+    {
+        /* Entries 0 and 1 hold the media type and an end of chain, all
+           clusters are free. The root directory stays empty. */
+        buffer[0] = MEDIA_FIXED;
+        buffer[1] = 0xFF;
+        buffer[2] = 0xFF;
+    }
+}
+
+} // namespace blinky
+
+#endif /* MOD_LOGGER */
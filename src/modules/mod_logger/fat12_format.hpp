@@ -0,0 +1,75 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef FAT12_FORMAT_HPP
+#define FAT12_FORMAT_HPP
+
+#include "target_cfg.h"
+
+#if MOD_LOGGER
+
+#include <cstdint>
+
+/*===========================================================================*/
+/* Constants                                                                 */
+/*===========================================================================*/
+
+#define FAT12_SECTOR_SIZE           512
+
+/* Clusters FAT12 can address. */
+#define FAT12_MAX_CLUSTERS          4084
+
+namespace blinky
+{
+
+/**
+ * @brief   Layout of an empty FAT12 file system.
+ * @details f_mkfs() rejects volumes below 128 sectors, e.g. the flash
+ *          EEPROM emulation of blinky. One sector per cluster, a single
+ *          FAT and a root directory of one sector keep the overhead at
+ *          three sectors on small volumes. Only the sectors up to the
+ *          first cluster need to be written, the data area is left as is.
+ */
+class Fat12Format
+{
+public:
+    explicit Fat12Format(uint32_t volumeSectors);
+
+    /**
+     * @return  Sectors to write, zero if the volume has no room for a
+     *          cluster or more than FAT12_MAX_CLUSTERS.
+     */
+    uint32_t GetSystemSectors() const
+    {
+        return systemSectors;
+    }
+
+    /**
+     * @brief   Writes the content of @p sector to @p buffer.
+     * @param[in] sector    below GetSystemSectors()
+     * @param[out] buffer   FAT12_SECTOR_SIZE bytes
+     */
+    void FillSector(uint32_t sector, uint8_t* buffer) const;
+
+private:
+    uint32_t sectors;
+    uint32_t fatSectors = 0;
+    uint32_t systemSectors = 0;
+};
+
+} // namespace blinky
+
+#endif /* MOD_LOGGER */
+
+#endif /* FAT12_FORMAT_HPP */
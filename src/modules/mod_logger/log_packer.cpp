@@ -0,0 +1,96 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "log_packer.hpp"
+
+#if MOD_LOGGER
+
+#include <algorithm>
+
+static_assert(sizeof(blinky::LogBlock) == MOD_LOGGER_BLOCK_SIZE,
+        "LogBlock must fill a sector exactly");
+
+namespace blinky
+{
+
+/*===========================================================================*/
+/* Exported functions                                                        */
+/*===========================================================================*/
+
+void LogPacker::Subscribe()
+{
+    channel->Subscribe(&cursor);
+    overrunsReported = 0;
+}
+
+bool LogPacker::Collect()
+{
+    const MotionSample* samples;
+    size_t count;
+
+    while (filling->count < LogBlock::CAPACITY &&
+            (count = channel->Peek(&cursor, &samples)) > 0)
+    {
+        count = std::min<size_t>(count, LogBlock::CAPACITY - filling->count);
+
+        uint16_t start = filling->count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            LogRecord& record = filling->records[start + i];
+            record.timestamp = samples[i].timestamp;
+            record.x = samples[i].x;
+            record.y = samples[i].y;
+            record.z = samples[i].z;
+            record.temperature = samples[i].temperature;
+        }
+
+        /* Copies of samples overwritten meanwhile are not kept, the ring
+           accounts the overwritten ones, the rest is counted here. */
+        uint32_t overruns = cursor.overruns;
+        if (channel->Consume(&cursor, count))
+            filling->count = start + count;
+        else
+            lost += count - (cursor.overruns - overruns);
+    }
+
+    return filling->count == LogBlock::CAPACITY;
+}
+
+const LogBlock* LogPacker::HandOver(bool writerFree)
+{
+    lost += cursor.overruns - overrunsReported;
+    overrunsReported = cursor.overruns;
+
+    LogBlock* block = filling;
+    if (!writerFree)
+    {
+        /* Reuse the block, the writer still owns the other one. */
+        lost += block->count;
+        block->count = 0;
+        return nullptr;
+    }
+
+    /* What does not fit the field is carried to the next block. */
+    block->sequence = sequence++;
+    block->lost = std::min<uint32_t>(lost, UINT16_MAX);
+    lost -= block->lost;
+
+    filling = (block == &blocks[0]) ? &blocks[1] : &blocks[0];
+    filling->count = 0;
+    return block;
+}
+
+} // namespace blinky
+
+#endif /* MOD_LOGGER */
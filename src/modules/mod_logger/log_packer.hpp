@@ -0,0 +1,127 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef LOG_PACKER_HPP
+#define LOG_PACKER_HPP
+
+#include "target_cfg.h"
+
+#if MOD_LOGGER
+
+#include "motion_channel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/*===========================================================================*/
+/* Constants                                                                 */
+/*===========================================================================*/
+
+/* Unit of the volume, blocks are written as whole sectors. */
+#define MOD_LOGGER_BLOCK_SIZE       512
+
+namespace blinky
+{
+
+/**
+ * @brief   One logged sample.
+ */
+struct LogRecord
+{
+    uint32_t timestamp;
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    int16_t temperature;
+};
+
+/**
+ * @brief   One sector of the log file.
+ * @details The file is a plain sequence of blocks. @p sequence counts the
+ *          blocks written, so a gap shows blocks missing from the file
+ *          itself, samples dropped before are in @p lost.
+ */
+struct LogBlock
+{
+    static constexpr size_t CAPACITY =
+            (MOD_LOGGER_BLOCK_SIZE - 8) / sizeof(LogRecord);
+
+    uint32_t sequence;
+    uint16_t count;
+    /* Samples missed since the previous block. */
+    uint16_t lost;
+    LogRecord records[CAPACITY];
+};
+
+/**
+ * @brief   Packs the samples of the motion channel into log blocks.
+ * @details Two blocks take turns, one is filled while the writer owns the
+ *          other. A full block the writer cannot take is reused, its
+ *          samples are counted as lost in the next block handed over. It
+ *          knows neither the kernel nor the storage, host tests run it on
+ *          a channel of their own.
+ */
+class LogPacker
+{
+public:
+    /**
+     * @param[in] pair      two blocks, reachable by the storage DMA
+     */
+    LogPacker(MotionChannel* source, LogBlock* pair)
+        : channel(source), blocks(pair), filling(&pair[0])
+    {
+        filling->count = 0;
+    }
+
+    /**
+     * @brief   Starts at the next sample written to the channel.
+     */
+    void Subscribe();
+
+    /**
+     * @brief   Moves new samples from the channel into the block being
+     *          filled.
+     * @return  true if the block is full, the rest stays in the channel
+     *          until it was handed over.
+     */
+    bool Collect();
+
+    bool IsEmpty() const
+    {
+        return filling->count == 0;
+    }
+
+    /**
+     * @brief   Closes the block being filled and starts the other one.
+     * @param[in] writerFree    the writer is done with the other block
+     * @return  The block to write, nullptr if it was dropped.
+     */
+    const LogBlock* HandOver(bool writerFree);
+
+private:
+    MotionChannel* channel;
+    MotionChannel::Cursor cursor;
+    LogBlock* blocks;
+    LogBlock* filling;
+    uint32_t overrunsReported = 0;
+    /* Samples missed since the last block handed over. */
+    uint32_t lost = 0;
+    uint32_t sequence = 0;
+};
+
+} // namespace blinky
+
+#endif /* MOD_LOGGER */
+
+#endif /* LOG_PACKER_HPP */
@@ -0,0 +1,107 @@
+/**
+ * @brief
+ *
+ * @addtogroup
+ * @{
+ */
+
+#include "mod_logger.hpp"
+
+#if MOD_LOGGER && MOD_LOGGER_DISKIO
+
+#include "diskio.h"
+
+#include <algorithm>
+
+/*
+ * FatFS drive 0 on MOD_LOGGER_DEVICE, in sectors of MOD_LOGGER_BLOCK_SIZE.
+ * The device takes care of erasing, e.g. the flash EEPROM emulation.
+ */
+
+static bool logger_disk_info(NVMDeviceInfo* info)
+{
+    return nvmGetInfo(MOD_LOGGER_DEVICE, info) == HAL_SUCCESS &&
+            info->sector_size * info->sector_num >= MOD_LOGGER_BLOCK_SIZE;
+}
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+    return disk_status(pdrv);
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+    NVMDeviceInfo info;
+
+    if (pdrv != 0 || !logger_disk_info(&info))
+        return STA_NOINIT;
+    return 0;
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
+{
+    if (pdrv != 0)
+        return RES_PARERR;
+
+    if (nvmRead(MOD_LOGGER_DEVICE, sector * MOD_LOGGER_BLOCK_SIZE,
+            count * MOD_LOGGER_BLOCK_SIZE, buff) != HAL_SUCCESS)
+        return RES_ERROR;
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
+{
+    if (pdrv != 0)
+        return RES_PARERR;
+
+    if (nvmWrite(MOD_LOGGER_DEVICE, sector * MOD_LOGGER_BLOCK_SIZE,
+            count * MOD_LOGGER_BLOCK_SIZE, buff) != HAL_SUCCESS)
+        return RES_ERROR;
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void* buff)
+{
+    NVMDeviceInfo info;
+
+    if (pdrv != 0)
+        return RES_PARERR;
+    if (!logger_disk_info(&info))
+        return RES_NOTRDY;
+
+    switch (cmd)
+    {
+    case CTRL_SYNC:
+        if (nvmSync(MOD_LOGGER_DEVICE) != HAL_SUCCESS)
+            return RES_ERROR;
+        return RES_OK;
+    case GET_SECTOR_COUNT:
+        *(DWORD*)buff = info.sector_size * info.sector_num /
+                MOD_LOGGER_BLOCK_SIZE;
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *(WORD*)buff = MOD_LOGGER_BLOCK_SIZE;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        /* Erase unit in sectors. */
+        *(DWORD*)buff = std::max<uint32_t>(
+                info.sector_size / MOD_LOGGER_BLOCK_SIZE, 1);
+        return RES_OK;
+    default:
+        return RES_PARERR;
+    }
+}
+
+#if HAL_USE_RTC
+DWORD get_fattime(void)
+{
+    RTCDateTime timespec;
+
+    rtcGetTime(&RTCD1, &timespec);
+    return rtcConvertDateTimeToFAT(&timespec);
+}
+#endif /* HAL_USE_RTC */
+
+#endif /* MOD_LOGGER && MOD_LOGGER_DISKIO */
+
+/** @} */
@@ -0,0 +1,224 @@
+/**
+ * @brief
+ *
+ * @addtogroup
+ * @{
+ */
+
+#include "mod_logger.hpp"
+
+#if MOD_LOGGER
+
+#include "ch_tools.h"
+#include "watchdog.h"
+#include "module_init_cpp.h"
+
+#include "qhal.h"
+
+#include "cyclecount.h"
+#include "startup.h"
+
+#if MOD_LOGGER_FORMAT
+#include "fat12_format.hpp"
+#include "diskio.h"
+#endif
+
+#include <algorithm>
+
+namespace blinky
+{
+LogBlock ModuleLogger::blocks[2];
+
+template <>
+ModuleLogger ModuleLoggerSingelton::instance MOD_LOGGER_SECTION = blinky::ModuleLogger();
+
+static THD_WORKING_AREA(waWriter, MOD_LOGGER_WRITER_THREADSIZE);
+
+/**
+ * @brief
+ */
+
+void ModuleLogger::Init()
+{
+    watchdog_register(WATCHDOG_MOD_LOGGER, MOD_LOGGER_WATCHDOG_DEADLINE);
+}
+
+void ModuleLogger::Start()
+{
+    Super::Start();
+}
+
+void ModuleLogger::Shutdown()
+{
+    Super::Shutdown();
+}
+
+void ModuleLogger::ThreadMain()
+{
+    chRegSetThreadName("logger");
+
+    chBSemObjectInit(&blockReady, true);
+    writer = chThdCreateStatic(waWriter, sizeof(waWriter),
+            MOD_LOGGER_WRITER_THREADPRIO, WriterMain, this);
+
+    /* Samples flow once the sensors are configured, logging an empty
+     * channel until then is pointless. */
+    startup_wait(STARTUP_MASK(STARTUP_MOD_SENSORS), MOD_LOGGER_START_TIMEOUT);
+    packer.Subscribe();
+    chEvtRegisterMask(motionChannel.GetEventSource(), &motionListener,
+            EVENT_MASK(0));
+    startup_ready(STARTUP_MOD_LOGGER);
+    while (!chibios_rt::BaseThread::shouldTerminate())
+    {
+        watchdog_reload(WATCHDOG_MOD_LOGGER);
+        chEvtWaitAnyTimeout(EVENT_MASK(0), TIME_MS2I(100));
+        while (packer.Collect())
+            HandOver();
+    }
+    chEvtUnregister(motionChannel.GetEventSource(), &motionListener);
+
+    /* Keep what was collected so far. */
+    if (!packer.IsEmpty())
+        HandOver();
+    chThdTerminate(writer);
+    chBSemSignal(&blockReady);
+    chThdWait(writer);
+}
+
+void ModuleLogger::HandOver()
+{
+    const LogBlock* block = packer.HandOver(!writerBusy && storageReady);
+    if (block == nullptr)
+    {
+        /* The samples show up as lost in the next block written. */
+        ++stats.blocksDropped;
+        return;
+    }
+
+    pending = block;
+    writerBusy = true;
+    chBSemSignal(&blockReady);
+}
+
+void ModuleLogger::WriterMain(void* arg)
+{
+    ModuleLogger* self = static_cast<ModuleLogger*>(arg);
+
+    chRegSetThreadName("logger writer");
+    self->storageReady = self->OpenLog();
+    while (true)
+    {
+        chBSemWait(&self->blockReady);
+        if (self->writerBusy)
+        {
+            self->WriteBlock(self->pending);
+            self->writerBusy = false;
+        }
+        if (chThdShouldTerminateX())
+            break;
+    }
+    self->CloseLog();
+}
+
+bool ModuleLogger::OpenLog()
+{
+    FRESULT result = f_mount(&fs, MOD_LOGGER_VOLUME, 1);
+#if MOD_LOGGER_FORMAT
+    if (result == FR_NO_FILESYSTEM && FormatVolume())
+        result = f_mount(&fs, MOD_LOGGER_VOLUME, 1);
+#endif
+    if (result != FR_OK)
+        return false;
+
+    if (f_open(&file, MOD_LOGGER_PATH, FA_WRITE | FA_OPEN_ALWAYS) != FR_OK)
+    {
+        f_mount(nullptr, MOD_LOGGER_VOLUME, 0);
+        return false;
+    }
+
+    /* Append on a block boundary, so each block stays a whole sector
+       and FatFS writes it without going through its own buffer. */
+    if (f_lseek(&file, f_size(&file) / MOD_LOGGER_BLOCK_SIZE *
+            MOD_LOGGER_BLOCK_SIZE) != FR_OK)
+    {
+        CloseLog();
+        return false;
+    }
+
+    return true;
+}
+
+#if MOD_LOGGER_FORMAT
+static_assert(MOD_LOGGER_BLOCK_SIZE == FAT12_SECTOR_SIZE,
+        "the volume is formatted in sectors of one block");
+
+bool ModuleLogger::FormatVolume()
+{
+    DWORD sectors = 0;
+    if (disk_ioctl(0, GET_SECTOR_COUNT, &sectors) != RES_OK)
+        return false;
+
+    Fat12Format format(sectors);
+    if (format.GetSystemSectors() == 0)
+        return false;
+
+    /* The packer keeps filling the first block until the storage is
+       ready, the second one is free until then. */
+    uint8_t* buffer = reinterpret_cast<uint8_t*>(&blocks[1]);
+    for (uint32_t sector = 0; sector < format.GetSystemSectors(); ++sector)
+    {
+        format.FillSector(sector, buffer);
+        if (disk_write(0, buffer, sector, 1) != RES_OK)
+            return false;
+    }
+    return disk_ioctl(0, CTRL_SYNC, nullptr) == RES_OK;
+}
+#endif
+
+void ModuleLogger::WriteBlock(const LogBlock* block)
+{
+    uint32_t start = cyclecount_get();
+
+    UINT written = 0;
+    FRESULT result = f_write(&file, block, sizeof(*block), &written);
+    if (result == FR_OK && ++unsynced >= MOD_LOGGER_SYNC_BLOCKS)
+    {
+        result = f_sync(&file);
+        unsynced = 0;
+    }
+
+    uint32_t cycles = cyclecount_get() - start;
+    stats.writeCyclesLast = cycles;
+    stats.writeCyclesWorst = std::max(stats.writeCyclesWorst, cycles);
+    writeCyclesTotal += cycles;
+
+    if (result != FR_OK || written != sizeof(*block))
+    {
+        /* Volume full or gone, stop logging instead of retrying. */
+        ++stats.blocksDropped;
+        storageReady = false;
+        return;
+    }
+    ++stats.blocksWritten;
+
+    /* The cycle count keeps its rate when the clock is scaled. */
+    stats.bytesPerSecond = (uint64_t)stats.blocksWritten *
+            MOD_LOGGER_BLOCK_SIZE * CYCLECOUNT_FREQUENCY / writeCyclesTotal;
+}
+
+void ModuleLogger::CloseLog()
+{
+    storageReady = false;
+    f_close(&file);
+    f_mount(nullptr, MOD_LOGGER_VOLUME, 0);
+}
+
+} // namespace blinky
+
+MODULE_INITCALL(6, qos::ModuleInit<blinky::ModuleLoggerSingelton>::Init,
+                qos::ModuleInit<blinky::ModuleLoggerSingelton>::Start,
+                qos::ModuleInit<blinky::ModuleLoggerSingelton>::Shutdown)
+
+#endif // MOD_LOGGER
+
+/** @} */
@@ -0,0 +1,190 @@
+/**
+ * @brief
+ *
+ * @addtogroup
+ * @{
+ */
+
+#ifndef MOD_LOGGER_H
+#define MOD_LOGGER_H
+
+#include "target_cfg.h"
+
+#include "threadedmodule.h"
+#include "singleton.h"
+
+#if MOD_LOGGER
+
+#include "log_packer.hpp"
+
+#include "ff.h"
+
+#include <cstdint>
+
+/*===========================================================================*/
+/* Pre-compile time settings                                                 */
+/*===========================================================================*/
+#ifndef MOD_LOGGER_THREADSIZE
+#define MOD_LOGGER_THREADSIZE 512
+#endif
+
+#ifndef MOD_LOGGER_THREADPRIO
+#define MOD_LOGGER_THREADPRIO LOWPRIO
+#endif
+
+/* Longest time the collector may go without a reload. Covers
+ * MOD_LOGGER_START_TIMEOUT as well. */
+#ifndef MOD_LOGGER_WATCHDOG_DEADLINE
+#define MOD_LOGGER_WATCHDOG_DEADLINE TIME_MS2I(2000)
+#endif
+
+/* FatFS needs a fair amount of stack, more with long file names. */
+#ifndef MOD_LOGGER_WRITER_THREADSIZE
+#define MOD_LOGGER_WRITER_THREADSIZE 1024
+#endif
+
+/* Storage may take its time, samples are buffered by the collector. */
+#ifndef MOD_LOGGER_WRITER_THREADPRIO
+#define MOD_LOGGER_WRITER_THREADPRIO LOWPRIO
+#endif
+
+/* Placement of the module instance, e.g. a faster RAM bank. */
+#ifndef MOD_LOGGER_SECTION
+#define MOD_LOGGER_SECTION
+#endif
+
+/* FatFS disk glue on MOD_LOGGER_DEVICE, the BaseNVMDevice holding the
+ * volume. FALSE if the target brings its own, e.g. on the SDC driver. */
+#ifndef MOD_LOGGER_DISKIO
+#define MOD_LOGGER_DISKIO TRUE
+#endif
+
+/* Formats the volume as FAT12 when it holds no file system yet, e.g. a
+ * fresh flash EEPROM emulation. Drive 0 of the own disk glue only. */
+#ifndef MOD_LOGGER_FORMAT
+#define MOD_LOGGER_FORMAT MOD_LOGGER_DISKIO
+#endif
+
+/* FatFS volume holding the log. */
+#ifndef MOD_LOGGER_VOLUME
+#define MOD_LOGGER_VOLUME ""
+#endif
+
+/* Samples are appended to this file. */
+#ifndef MOD_LOGGER_PATH
+#define MOD_LOGGER_PATH "motion.log"
+#endif
+
+/* Blocks written before the directory entry is updated, bounds the loss
+ * on power failure. */
+#ifndef MOD_LOGGER_SYNC_BLOCKS
+#define MOD_LOGGER_SYNC_BLOCKS 16
+#endif
+
+/* Longest wait for ModuleSensors at start-up, logging starts anyway after
+ * it. Must stay below the watchdog period. */
+#ifndef MOD_LOGGER_START_TIMEOUT
+#define MOD_LOGGER_START_TIMEOUT TIME_S2I(1)
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks                                        */
+/*===========================================================================*/
+
+#if !MOD_SENSORS
+#error "MOD_LOGGER requires MOD_SENSORS"
+#endif
+
+#if MOD_LOGGER_SYNC_BLOCKS < 1
+#error "MOD_LOGGER_SYNC_BLOCKS out of range"
+#endif
+
+#if MOD_LOGGER_DISKIO && !defined(MOD_LOGGER_DEVICE)
+#error "MOD_LOGGER_DISKIO requires MOD_LOGGER_DEVICE"
+#endif
+
+#if MOD_LOGGER_FORMAT && !MOD_LOGGER_DISKIO
+#error "MOD_LOGGER_FORMAT requires MOD_LOGGER_DISKIO"
+#endif
+
+namespace blinky
+{
+
+/**
+ * @brief   Kept up to date for the debugger, see make/gdb/logger.py.
+ */
+struct LoggerStats
+{
+    uint32_t blocksWritten;
+    /* Blocks discarded because the writer was still busy or the volume
+     * is not available. */
+    uint32_t blocksDropped;
+    /* Duration of one block write, in cycles of CYCLECOUNT_FREQUENCY. */
+    uint32_t writeCyclesLast;
+    uint32_t writeCyclesWorst;
+    /* Write throughput while the writer was busy. */
+    uint32_t bytesPerSecond;
+};
+
+/**
+ * @brief   Logs the samples of ModuleSensors to a FatFS volume.
+ * @details The module thread copies samples from the motion channel into
+ *          one of two sector sized blocks. A full block is handed to a
+ *          writer thread, collection continues in the other one. If the
+ *          writer has not finished the previous block by then, the full
+ *          block is dropped, so storage never stalls the acquisition.
+ * @note    A volume without file system is formatted as FAT12 on first
+ *          use, see MOD_LOGGER_FORMAT. Larger ones are up to the host.
+ */
+class ModuleLogger : public qos::ThreadedModule<MOD_LOGGER_THREADSIZE>
+{
+    using Super = qos::ThreadedModule<MOD_LOGGER_THREADSIZE>;
+
+  public:
+    void Init() override;
+    void Start() override;
+    void Shutdown() override;
+
+  protected:
+    tprio_t GetThreadPrio() const override { return MOD_LOGGER_THREADPRIO; };
+    void ThreadMain() override;
+
+  private:
+    static void WriterMain(void* arg);
+    void HandOver();
+    bool OpenLog();
+#if MOD_LOGGER_FORMAT
+    bool FormatVolume();
+#endif
+    void WriteBlock(const LogBlock* block);
+    void CloseLog();
+
+    /* Out of the module instance, which may be placed in a RAM bank the
+       storage DMA cannot reach. */
+    static LogBlock blocks[2];
+
+    event_listener_t motionListener;
+    LogPacker packer{&motionChannel, blocks};
+
+    /* Block owned by the writer. */
+    const LogBlock* pending = nullptr;
+    volatile bool writerBusy = false;
+    volatile bool storageReady = false;
+    binary_semaphore_t blockReady;
+    thread_t* writer = nullptr;
+
+    FATFS fs;
+    FIL file;
+    uint32_t unsynced = 0;
+
+    LoggerStats stats = {};
+    uint64_t writeCyclesTotal = 0;
+};
+
+typedef qos::Singleton<ModuleLogger> ModuleLoggerSingelton;
+
+} // namespace blinky
+
+#endif /* MOD_LOGGER */
+
+#endif /* MOD_LOGGER_H */
@@ -0,0 +1,159 @@
+/**
+ * @brief
+ *
+ * @addtogroup
+ * @{
+ */
+
+#include "mod_monitor.hpp"
+
+#if MOD_MONITOR
+
+#include "ch_tools.h"
+#include "watchdog.h"
+#include "module_init_cpp.h"
+
+#include "qhal.h"
+
+#include "trace.h"
+#include "startup.h"
+
+#include <algorithm>
+
+namespace blinky
+{
+template <>
+ModuleMonitor ModuleMonitorSingelton::instance MOD_MONITOR_SECTION = blinky::ModuleMonitor();
+
+/*
+ * Bytes at the bottom of the working area still holding the fill pattern.
+ * Created threads keep their thread_t at the top of the working area,
+ * the scan stops there at the latest.
+ */
+static size_t StackFree(const thread_t* tp)
+{
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(tp->wabase);
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(tp);
+    const uint8_t* p = base;
+
+    if (end <= base)
+    {
+        /* The main thread runs on the process stack, there is no known
+           end but the part in use stops the scan. */
+        end = nullptr;
+    }
+
+    while ((end == nullptr || p < end) && *p == CH_DBG_STACK_FILL_VALUE)
+        ++p;
+
+    return p - base;
+}
+
+/**
+ * @brief
+ */
+
+void ModuleMonitor::Init()
+{
+    watchdog_register(WATCHDOG_MOD_MONITOR, MOD_MONITOR_WATCHDOG_DEADLINE);
+}
+
+void ModuleMonitor::Start()
+{
+    Super::Start();
+}
+
+void ModuleMonitor::Shutdown()
+{
+    Super::Shutdown();
+}
+
+void ModuleMonitor::ThreadMain()
+{
+    chRegSetThreadName("monitor");
+    startup_ready(STARTUP_MOD_MONITOR);
+
+    systime_t last = chVTGetSystemTime();
+    while (!chibios_rt::BaseThread::shouldTerminate())
+    {
+        watchdog_reload(WATCHDOG_MOD_MONITOR);
+        chThdSleep(MOD_MONITOR_INTERVAL);
+
+        systime_t now = chVTGetSystemTime();
+        Update(chTimeDiffX(last, now));
+        last = now;
+    }
+}
+
+void ModuleMonitor::Update(sysinterval_t elapsed)
+{
+    const thread_t* idle = chSysGetIdleThreadX();
+    size_t count = 0;
+    uint32_t busy = 0;
+
+    stackFreeMin = UINT16_MAX;
+    for (thread_t* tp = chRegFirstThread(); tp != nullptr;
+            tp = chRegNextThread(tp))
+    {
+        if (count == current.size())
+        {
+            /* chRegNextThread() drops the reference, stop through it. */
+            continue;
+        }
+
+        systime_t time = tp->time;
+        systime_t start = time;
+        for (size_t i = 0; i < threads; ++i)
+        {
+            if (previous[i].thread == tp)
+            {
+                start = previous[i].time;
+                break;
+            }
+        }
+
+        /* Threads created during the interval count from now on. */
+        uint32_t ticks = chTimeDiffX(start, time);
+        uint16_t load = std::min<uint32_t>(ticks * 1000 / elapsed, 1000);
+        if (tp != idle)
+            busy += ticks;
+
+        uint16_t margin = std::min<size_t>(StackFree(tp), UINT16_MAX);
+        stackFreeMin = std::min(stackFreeMin, margin);
+
+        current[count] = {tp, time};
+        report[count] = {chRegGetThreadNameX(tp), load, margin};
+        ++count;
+    }
+
+    previous = current;
+    threads = count;
+    cpuLoad = std::min<uint32_t>(busy * 1000 / elapsed, 1000);
+
+#if MOD_MONITOR_TRACE_FREEZE
+    if (cpuLoad > MOD_MONITOR_LOAD_WARNING)
+        trace_freeze();
+#endif /* MOD_MONITOR_TRACE_FREEZE */
+
+#if HAL_USE_LED
+    if (cpuLoad > MOD_MONITOR_LOAD_WARNING ||
+            stackFreeMin < MOD_MONITOR_STACK_WARNING)
+    {
+        ledOn(LED_WARNING);
+    }
+    else
+    {
+        ledOff(LED_WARNING);
+    }
+#endif /* HAL_USE_LED */
+}
+
+} // namespace blinky
+
+MODULE_INITCALL(6, qos::ModuleInit<blinky::ModuleMonitorSingelton>::Init,
+                qos::ModuleInit<blinky::ModuleMonitorSingelton>::Start,
+                qos::ModuleInit<blinky::ModuleMonitorSingelton>::Shutdown)
+
+#endif // MOD_MONITOR
+
+/** @} */
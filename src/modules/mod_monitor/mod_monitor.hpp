@@ -0,0 +1,142 @@
+/**
+ * @brief
+ *
+ * @addtogroup
+ * @{
+ */
+
+#ifndef MOD_MONITOR_H
+#define MOD_MONITOR_H
+
+#include "target_cfg.h"
+
+#include "threadedmodule.h"
+#include "singleton.h"
+
+#if MOD_MONITOR
+
+#include <array>
+#include <cstdint>
+
+/*===========================================================================*/
+/* Pre-compile time settings                                                 */
+/*===========================================================================*/
+#ifndef MOD_MONITOR_THREADSIZE
+#define MOD_MONITOR_THREADSIZE 384
+#endif
+
+/* Above all modules, so the report keeps coming while they saturate the
+ * CPU. */
+#ifndef MOD_MONITOR_THREADPRIO
+#define MOD_MONITOR_THREADPRIO (HIGHPRIO - 1)
+#endif
+
+#ifndef MOD_MONITOR_SECTION
+#define MOD_MONITOR_SECTION
+#endif
+
+/* Interval the loads are averaged over. */
+#ifndef MOD_MONITOR_INTERVAL
+#define MOD_MONITOR_INTERVAL TIME_S2I(1)
+#endif
+
+/* Longest time between two reports before the watchdog reports us. */
+#ifndef MOD_MONITOR_WATCHDOG_DEADLINE
+#define MOD_MONITOR_WATCHDOG_DEADLINE (2 * MOD_MONITOR_INTERVAL)
+#endif
+
+/* Threads covered by the report, including main and idle. */
+#ifndef MOD_MONITOR_MAX_THREADS
+#define MOD_MONITOR_MAX_THREADS 10
+#endif
+
+/* CPU load in 0.1 % above which LED_WARNING is lit. */
+#ifndef MOD_MONITOR_LOAD_WARNING
+#define MOD_MONITOR_LOAD_WARNING 900
+#endif
+
+/* Untouched stack in bytes below which LED_WARNING is lit. */
+#ifndef MOD_MONITOR_STACK_WARNING
+#define MOD_MONITOR_STACK_WARNING 64
+#endif
+
+/* Freeze the kernel trace the first time the load warning trips, so the
+ * events that led to it can be fetched with the debugger. */
+#ifndef MOD_MONITOR_TRACE_FREEZE
+#define MOD_MONITOR_TRACE_FREEZE TRUE
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks                                        */
+/*===========================================================================*/
+
+#if CH_DBG_THREADS_PROFILING != TRUE
+#error "MOD_MONITOR requires CH_DBG_THREADS_PROFILING"
+#endif
+
+#if CH_DBG_FILL_THREADS != TRUE
+#error "MOD_MONITOR requires CH_DBG_FILL_THREADS"
+#endif
+
+#if (CH_DBG_ENABLE_STACK_CHECK != TRUE) && (CH_CFG_USE_DYNAMIC != TRUE)
+#error "MOD_MONITOR requires the working area base of threads"
+#endif
+
+namespace blinky
+{
+
+struct ThreadReport
+{
+    const char* name;
+    /* Share of the last interval in 0.1 %, interrupts included. */
+    uint16_t load;
+    /* Stack bytes never written since the thread was created. */
+    uint16_t stackFree;
+};
+
+/**
+ * @brief   Reports CPU load and stack margin of all threads.
+ * @details Every MOD_MONITOR_INTERVAL the registry is walked, the system
+ *          ticks each thread ran for are turned into a load and the fill
+ *          pattern left in each working area into a stack margin. The
+ *          report is kept in RAM for the debugger, LED_WARNING signals
+ *          saturation or a short stack in the field.
+ */
+class ModuleMonitor : public qos::ThreadedModule<MOD_MONITOR_THREADSIZE>
+{
+    using Super = qos::ThreadedModule<MOD_MONITOR_THREADSIZE>;
+
+  public:
+    void Init() override;
+    void Start() override;
+    void Shutdown() override;
+
+  protected:
+    tprio_t GetThreadPrio() const override { return MOD_MONITOR_THREADPRIO; };
+    void ThreadMain() override;
+
+  private:
+    struct Sample
+    {
+        const thread_t* thread;
+        systime_t time;
+    };
+
+    void Update(sysinterval_t elapsed);
+
+    std::array<Sample, MOD_MONITOR_MAX_THREADS> previous = {};
+    std::array<Sample, MOD_MONITOR_MAX_THREADS> current = {};
+    std::array<ThreadReport, MOD_MONITOR_MAX_THREADS> report = {};
+    size_t threads = 0;
+    /* Everything but the idle thread, in 0.1 %. */
+    uint16_t cpuLoad = 0;
+    uint16_t stackFreeMin = 0;
+};
+
+typedef qos::Singleton<ModuleMonitor> ModuleMonitorSingelton;
+
+} // namespace blinky
+
+#endif /* MOD_MONITOR */
+
+#endif /* MOD_MONITOR_H */
@@ -0,0 +1,42 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef ACCEL_VECTOR_HPP
+#define ACCEL_VECTOR_HPP
+
+#include <cstdint>
+
+/*===========================================================================*/
+/* Constants                                                                 */
+/*===========================================================================*/
+
+/* Samples the LIS3DH FIFO can hold. */
+#define LIS3DH_FIFO_DEPTH 32
+
+namespace blinky
+{
+
+/**
+ * @brief   Acceleration in raw LIS3DH counts, left aligned 16 bit.
+ */
+struct AccelVector
+{
+    int16_t x;
+    int16_t y;
+    int16_t z;
+};
+
+} // namespace blinky
+
+#endif /* ACCEL_VECTOR_HPP */
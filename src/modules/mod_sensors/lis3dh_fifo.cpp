@@ -0,0 +1,190 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "lis3dh_fifo.hpp"
+#include "lis3dh_regs.hpp"
+
+#if MOD_SENSORS
+
+/*===========================================================================*/
+/* Local definitions                                                         */
+/*===========================================================================*/
+
+/* Bytes per sample, X, Y and Z little endian. */
+#define LIS3DH_SAMPLE_SIZE          6
+
+namespace blinky
+{
+
+/*===========================================================================*/
+/* Local variables                                                           */
+/*===========================================================================*/
+
+/*
+ * Transfer buffers are kept out of the module instance, which may be
+ * placed in a RAM bank the DMA cannot reach. The first byte clocked in
+ * while the address goes out is dropped.
+ */
+static uint8_t txbuf[1 + LIS3DH_FIFO_DEPTH * LIS3DH_SAMPLE_SIZE];
+static uint8_t rxbuf[1 + LIS3DH_FIFO_DEPTH * LIS3DH_SAMPLE_SIZE];
+
+/* Owner of the transfer in flight, for the SPI end callback. */
+static Lis3dhFifo* active;
+
+/*===========================================================================*/
+/* Exported functions                                                        */
+/*===========================================================================*/
+
+void Lis3dhFifo::Start(LIS3DHDriver* driver, SpiBus* spiBus,
+        ioline_t irqLine, uint8_t watermark)
+{
+    devp = driver;
+    bus = spiBus;
+    line = irqLine;
+
+    chEvtObjectInit(&source);
+    asyncCfg = *devp->config->spicfg;
+    asyncCfg.end_cb = TransferDone;
+
+    uint8_t ctrl5 = Lis3dhReadRegister(devp, bus, LIS3DH_REG_CTRL5);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CTRL5,
+            ctrl5 | LIS3DH_CTRL5_FIFO_EN);
+    SetWatermark(watermark);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CTRL3, LIS3DH_CTRL3_I1_WTM);
+
+    /* INT1 is active high and stays set while the FIFO is above the
+       watermark. */
+    palSetLineCallback(line, WatermarkReached, this);
+    palEnableLineEvent(line, PAL_EVENT_MODE_RISING_EDGE);
+}
+
+void Lis3dhFifo::Stop()
+{
+    chDbgAssert(phase == Phase::Idle, "drain in progress");
+
+    palDisableLineEvent(line);
+
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CTRL3, 0);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_FIFO_CTRL,
+            LIS3DH_FIFO_MODE_BYPASS);
+    uint8_t ctrl5 = Lis3dhReadRegister(devp, bus, LIS3DH_REG_CTRL5);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CTRL5,
+            ctrl5 & ~LIS3DH_CTRL5_FIFO_EN);
+}
+
+void Lis3dhFifo::SetWatermark(uint8_t watermark)
+{
+    chDbgAssert((watermark > 0) && (watermark < LIS3DH_FIFO_DEPTH),
+            "watermark out of range");
+
+    /* Passing through bypass mode empties the FIFO. */
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_FIFO_CTRL,
+            LIS3DH_FIFO_MODE_BYPASS);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_FIFO_CTRL,
+            LIS3DH_FIFO_MODE_STREAM | (watermark & LIS3DH_FIFO_FTH_MASK));
+}
+
+bool Lis3dhFifo::IsAboveWatermark() const
+{
+    return palReadLine(line) == PAL_HIGH;
+}
+
+void Lis3dhFifo::StartDrain()
+{
+    chDbgAssert(phase == Phase::Idle, "drain in progress");
+
+    SPIDriver* spip = bus->Acquire(&asyncCfg);
+    active = this;
+    phase = Phase::Status;
+    pending = 0;
+
+    txbuf[0] = LIS3DH_REG_FIFO_SRC | LIS3DH_SPI_READ;
+    spiSelect(spip);
+    spiStartExchange(spip, 2, txbuf, rxbuf);
+}
+
+size_t Lis3dhFifo::Collect(AccelVector* samples, size_t max) const
+{
+    size_t count = (pending < max) ? pending : max;
+
+    const uint8_t* p = rxbuf + 1;
+    for (size_t i = 0; i < count; ++i, p += LIS3DH_SAMPLE_SIZE)
+    {
+        samples[i].x = static_cast<int16_t>(p[0] | (p[1] << 8));
+        samples[i].y = static_cast<int16_t>(p[2] | (p[3] << 8));
+        samples[i].z = static_cast<int16_t>(p[4] | (p[5] << 8));
+    }
+
+    return count;
+}
+
+/*===========================================================================*/
+/* Local functions                                                           */
+/*===========================================================================*/
+
+void Lis3dhFifo::WatermarkReached(void* arg)
+{
+    Lis3dhFifo* self = static_cast<Lis3dhFifo*>(arg);
+
+    osalSysLockFromISR();
+    chEvtBroadcastFlagsI(&self->source, LIS3DH_FIFO_WATERMARK);
+    osalSysUnlockFromISR();
+}
+
+void Lis3dhFifo::TransferDone(SPIDriver* spip)
+{
+    Lis3dhFifo* self = active;
+
+    osalSysLockFromISR();
+    spiUnselectI(spip);
+
+    if (self->phase == Phase::Status)
+    {
+        uint8_t src = rxbuf[1];
+        size_t count = src & LIS3DH_FIFO_SRC_FSS_MASK;
+        if (src & LIS3DH_FIFO_SRC_OVRN)
+        {
+            count = LIS3DH_FIFO_DEPTH;
+            ++self->overruns;
+        }
+
+        if (count > 0)
+        {
+            /* The address wraps from OUT_Z_H back to OUT_X_L while the
+               FIFO is enabled, so all samples come in one transfer. */
+            self->phase = Phase::Data;
+            self->pending = count;
+            txbuf[0] = LIS3DH_REG_OUT_X_L | LIS3DH_SPI_READ |
+                    LIS3DH_SPI_AUTOINC;
+            spiSelectI(spip);
+            spiStartExchangeI(spip, 1 + count * LIS3DH_SAMPLE_SIZE,
+                    txbuf, rxbuf);
+            osalSysUnlockFromISR();
+            return;
+        }
+    }
+
+    self->phase = Phase::Idle;
+    self->bus->ReleaseI();
+    chEvtBroadcastFlagsI(&self->source, LIS3DH_FIFO_DRAINED);
+    if (self->callback != nullptr)
+    {
+        self->callback(self->callbackArg);
+    }
+    osalSysUnlockFromISR();
+}
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
@@ -0,0 +1,157 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef LIS3DH_FIFO_HPP
+#define LIS3DH_FIFO_HPP
+
+#include "target_cfg.h"
+
+#if MOD_SENSORS
+
+#include "qhal.h"
+#include "lis3dh.h"
+#include "spi_bus.hpp"
+#include "accel_vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/*===========================================================================*/
+/* Pre-compile time settings                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Longest wait for a watermark event.
+ * @details The FIFO is drained on timeout as well, so a missed interrupt
+ *          costs latency only. Also bounds the watchdog reload interval.
+ */
+#ifndef MOD_SENSORS_FIFO_TIMEOUT
+#define MOD_SENSORS_FIFO_TIMEOUT TIME_MS2I(1000)
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks                                        */
+/*===========================================================================*/
+
+#if !defined(MOD_SENSORS_FIFO_LINE)
+#error "MOD_SENSORS_FIFO_LINE must name the PAL line of LIS3DH INT1"
+#endif
+
+#if (PAL_USE_CALLBACKS != TRUE)
+#error "LIS3DH FIFO acquisition requires PAL_USE_CALLBACKS"
+#endif
+
+namespace blinky
+{
+
+/**
+ * @brief   Runs the LIS3DH FIFO in stream mode with the watermark routed
+ *          to INT1.
+ * @details The sensor collects samples on its own, the owning thread only
+ *          wakes up once the watermark is reached, which is broadcast as
+ *          @p LIS3DH_FIFO_WATERMARK. The FIFO is then read
+ *          asynchronously: the fill level and all samples are fetched by
+ *          chained SPI DMA transfers from the transfer complete interrupt,
+ *          which also hands the bus back and signals completion.
+ * @note    Must be used from one thread only, after lis3dhStart().
+ */
+class Lis3dhFifo
+{
+public:
+    typedef void (*Callback)(void* arg);
+
+    void Start(LIS3DHDriver* driver, SpiBus* spiBus, ioline_t irqLine,
+            uint8_t watermark);
+    void Stop();
+
+    /**
+     * @brief   Changes the FIFO level raising the watermark event.
+     * @note    Empties the FIFO, so a following batch never mixes samples
+     *          taken before and after a data rate change.
+     */
+    void SetWatermark(uint8_t watermark);
+
+    /**
+     * @brief   Level of the watermark interrupt.
+     * @details No new event follows if the level was reached again while
+     *          draining, so check this before waiting.
+     */
+    bool IsAboveWatermark() const;
+
+    /**
+     * @brief   Starts reading all stored samples and returns immediately.
+     * @details Completion is broadcast as @p LIS3DH_FIFO_DRAINED and
+     *          reported to the callback, if any. Until then the caller must
+     *          not start another drain or touch the sensor.
+     */
+    void StartDrain();
+
+    /**
+     * @brief   Decodes the samples of the last completed drain, oldest
+     *          first.
+     * @return  Number of samples written to @p samples.
+     */
+    size_t Collect(AccelVector* samples, size_t max) const;
+
+    /**
+     * @brief   Called from ISR context when a drain completes.
+     */
+    void SetCallback(Callback cb, void* arg)
+    {
+        callback = cb;
+        callbackArg = arg;
+    }
+
+    /**
+     * @note    Listeners can register once Start() was called.
+     */
+    event_source_t* GetEventSource()
+    {
+        return &source;
+    }
+
+    static constexpr eventflags_t LIS3DH_FIFO_DRAINED = 1;
+    static constexpr eventflags_t LIS3DH_FIFO_WATERMARK = 2;
+
+    /* Number of drains that found the FIFO overflown. */
+    uint32_t overruns = 0;
+
+private:
+    enum class Phase : uint8_t
+    {
+        Idle,
+        Status,
+        Data,
+    };
+
+    static void WatermarkReached(void* arg);
+    static void TransferDone(SPIDriver* spip);
+
+    LIS3DHDriver* devp = nullptr;
+    SpiBus* bus = nullptr;
+    ioline_t line = 0;
+    /* Sensor SPI settings plus the transfer complete callback. */
+    SPIConfig asyncCfg = {};
+    event_source_t source;
+    Callback callback = nullptr;
+    void* callbackArg = nullptr;
+    volatile Phase phase = Phase::Idle;
+    size_t pending = 0;
+};
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
+
+#endif /* LIS3DH_FIFO_HPP */
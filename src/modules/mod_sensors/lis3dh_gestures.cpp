@@ -0,0 +1,163 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "lis3dh_gestures.hpp"
+#include "lis3dh_regs.hpp"
+
+#if MOD_SENSORS
+
+namespace blinky
+{
+
+/*===========================================================================*/
+/* Local functions                                                           */
+/*===========================================================================*/
+
+/* Time registers are 7 bit wide, zero would disable the check. */
+static uint8_t MsToPeriods(uint32_t ms, uint16_t hz)
+{
+    uint32_t periods = (ms * hz + 500) / 1000;
+    if (periods < 1)
+        return 1;
+    if (periods > 127)
+        return 127;
+    return periods;
+}
+
+/*===========================================================================*/
+/* Exported functions                                                        */
+/*===========================================================================*/
+
+void Lis3dhGestures::Start(LIS3DHDriver* driver, SpiBus* spiBus,
+        ioline_t irqLine)
+{
+    devp = driver;
+    bus = spiBus;
+    line = irqLine;
+
+    chEvtObjectInit(&source);
+
+    /* Taps are short peaks, keep gravity out of the click path. Free fall
+     * needs it, the standby wake-up may have left the filter on. */
+    uint8_t ctrl2 = Lis3dhReadRegister(devp, bus, LIS3DH_REG_CTRL2);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CTRL2,
+            (ctrl2 & ~LIS3DH_CTRL2_HP_IA1) | LIS3DH_CTRL2_HPCLICK);
+
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CLICK_CFG,
+            LIS3DH_CLICK_CFG_ALL);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CLICK_THS,
+            LIS3DH_CLICK_THS_LIR | MOD_SENSORS_TAP_THRESHOLD);
+    SetDataRate(100);
+
+    /* Free fall: all axes low at the same time. */
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_INT1_THS,
+            MOD_SENSORS_FREEFALL_THRESHOLD);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_INT1_CFG,
+            LIS3DH_INT_CFG_AOI | LIS3DH_INT_CFG_ZLIE | LIS3DH_INT_CFG_YLIE |
+            LIS3DH_INT_CFG_XLIE);
+    uint8_t ctrl5 = Lis3dhReadRegister(devp, bus, LIS3DH_REG_CTRL5);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CTRL5,
+            ctrl5 | LIS3DH_CTRL5_LIR_INT1);
+
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CTRL6,
+            LIS3DH_CTRL6_I2_CLICK | LIS3DH_CTRL6_I2_IA1);
+
+    palSetLineCallback(line, InterruptRaised, this);
+    palEnableLineEvent(line, PAL_EVENT_MODE_RISING_EDGE);
+
+    /* Clear what was latched before, INT2 would stay high otherwise. */
+    Read();
+}
+
+void Lis3dhGestures::Stop()
+{
+    palDisableLineEvent(line);
+
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CTRL6, 0);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_INT1_CFG, 0);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CLICK_CFG, 0);
+    Read();
+}
+
+void Lis3dhGestures::SetDataRate(uint16_t hz)
+{
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_TIME_LIMIT,
+            MsToPeriods(MOD_SENSORS_TAP_TIME_LIMIT_MS, hz));
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_TIME_LATENCY,
+            MsToPeriods(MOD_SENSORS_TAP_LATENCY_MS, hz));
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_TIME_WINDOW,
+            MsToPeriods(MOD_SENSORS_TAP_WINDOW_MS, hz));
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_INT1_DURATION,
+            MsToPeriods(MOD_SENSORS_FREEFALL_DURATION_MS, hz));
+}
+
+void Lis3dhGestures::ArmWakeup()
+{
+    Lis3dhSetDataRate(devp, bus, MOD_SENSORS_WAKE_ODR);
+
+    /* Any axis above the threshold, gravity filtered out. Reading the
+     * reference register resets the filter to the current position. */
+    uint8_t ctrl2 = Lis3dhReadRegister(devp, bus, LIS3DH_REG_CTRL2);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CTRL2,
+            ctrl2 | LIS3DH_CTRL2_HP_IA1);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_INT1_THS,
+            MOD_SENSORS_WAKE_THRESHOLD);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_INT1_DURATION, 0);
+    Lis3dhReadRegister(devp, bus, LIS3DH_REG_REFERENCE);
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_INT1_CFG,
+            LIS3DH_INT_CFG_ZHIE | LIS3DH_INT_CFG_YHIE | LIS3DH_INT_CFG_XHIE);
+
+    /* Stop() kept the latch, only the routing was removed. */
+    Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CTRL6, LIS3DH_CTRL6_I2_IA1);
+    Lis3dhReadRegister(devp, bus, LIS3DH_REG_INT1_SRC);
+}
+
+uint8_t Lis3dhGestures::Read()
+{
+    uint8_t gestures = 0;
+
+    uint8_t click = Lis3dhReadRegister(devp, bus, LIS3DH_REG_CLICK_SRC);
+    if (click & LIS3DH_CLICK_SRC_IA)
+    {
+        if (click & LIS3DH_CLICK_SRC_DCLICK)
+            gestures |= GESTURE_DOUBLE_TAP;
+        if (click & LIS3DH_CLICK_SRC_SCLICK)
+            gestures |= GESTURE_TAP;
+    }
+
+    uint8_t inertial = Lis3dhReadRegister(devp, bus, LIS3DH_REG_INT1_SRC);
+    if (inertial & LIS3DH_INT_SRC_IA)
+    {
+        gestures |= GESTURE_FREEFALL;
+    }
+
+    return gestures;
+}
+
+/*===========================================================================*/
+/* Local functions                                                           */
+/*===========================================================================*/
+
+void Lis3dhGestures::InterruptRaised(void* arg)
+{
+    Lis3dhGestures* self = static_cast<Lis3dhGestures*>(arg);
+
+    osalSysLockFromISR();
+    chEvtBroadcastFlagsI(&self->source, LIS3DH_GESTURE_PENDING);
+    osalSysUnlockFromISR();
+}
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
@@ -0,0 +1,167 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef LIS3DH_GESTURES_HPP
+#define LIS3DH_GESTURES_HPP
+
+#include "target_cfg.h"
+
+#if MOD_SENSORS
+
+#include "qhal.h"
+#include "lis3dh.h"
+#include "spi_bus.hpp"
+
+#include <cstdint>
+
+/*===========================================================================*/
+/* Pre-compile time settings                                                 */
+/*===========================================================================*/
+
+/*
+ * Thresholds count 16 mg at LIS3DH_FS_2G. Times are converted to output
+ * data rate periods by SetDataRate().
+ */
+
+/**
+ * @brief   Acceleration peak of a tap, 0.5 g.
+ */
+#ifndef MOD_SENSORS_TAP_THRESHOLD
+#define MOD_SENSORS_TAP_THRESHOLD 32
+#endif
+
+/**
+ * @brief   Longest a peak may last to count as a tap, in milliseconds.
+ */
+#ifndef MOD_SENSORS_TAP_TIME_LIMIT_MS
+#define MOD_SENSORS_TAP_TIME_LIMIT_MS 50
+#endif
+
+/**
+ * @brief   Dead time after a tap before the second one, in milliseconds.
+ */
+#ifndef MOD_SENSORS_TAP_LATENCY_MS
+#define MOD_SENSORS_TAP_LATENCY_MS 100
+#endif
+
+/**
+ * @brief   Window for the second tap after the dead time, in milliseconds.
+ */
+#ifndef MOD_SENSORS_TAP_WINDOW_MS
+#define MOD_SENSORS_TAP_WINDOW_MS 300
+#endif
+
+/**
+ * @brief   High-pass filtered acceleration waking the unit, 128 mg.
+ */
+#ifndef MOD_SENSORS_WAKE_THRESHOLD
+#define MOD_SENSORS_WAKE_THRESHOLD 8
+#endif
+
+/**
+ * @brief   Output data rate in Hz while the MCU is in standby.
+ */
+#ifndef MOD_SENSORS_WAKE_ODR
+#define MOD_SENSORS_WAKE_ODR 10
+#endif
+
+/**
+ * @brief   All axes below this count as free fall, 350 mg.
+ */
+#ifndef MOD_SENSORS_FREEFALL_THRESHOLD
+#define MOD_SENSORS_FREEFALL_THRESHOLD 22
+#endif
+
+/**
+ * @brief   Free fall has to last this long, in milliseconds.
+ */
+#ifndef MOD_SENSORS_FREEFALL_DURATION_MS
+#define MOD_SENSORS_FREEFALL_DURATION_MS 30
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks                                        */
+/*===========================================================================*/
+
+#if !defined(MOD_SENSORS_GESTURE_LINE)
+#error "MOD_SENSORS_GESTURE_LINE must name the PAL line of LIS3DH INT2"
+#endif
+
+namespace blinky
+{
+
+/**
+ * @brief   Lets the LIS3DH detect taps and free fall on its own.
+ * @details The click and the inertial interrupt generator 1 are routed to
+ *          INT2, its rising edge is broadcast as
+ *          @p LIS3DH_GESTURE_PENDING. Read() then fetches and clears the
+ *          latched interrupt sources.
+ * @note    Must be used from one thread only, after lis3dhStart().
+ */
+class Lis3dhGestures
+{
+public:
+    enum Gesture : uint8_t
+    {
+        GESTURE_TAP = 0x01,
+        GESTURE_DOUBLE_TAP = 0x02,
+        GESTURE_FREEFALL = 0x04,
+    };
+
+    void Start(LIS3DHDriver* driver, SpiBus* spiBus, ioline_t irqLine);
+    void Stop();
+
+    /**
+     * @brief   Reprograms the time windows after a data rate change.
+     * @note    Start() leaves them at 100 Hz.
+     */
+    void SetDataRate(uint16_t hz);
+
+    /**
+     * @brief   Returns the gestures detected since the last call.
+     */
+    uint8_t Read();
+
+    /**
+     * @brief   Leaves the LIS3DH latching any movement on INT2.
+     * @details Used as wake-up source while the MCU is in standby, Start()
+     *          undoes it.
+     * @note    Call after Stop().
+     */
+    void ArmWakeup();
+
+    /**
+     * @note    Listeners can register once Start() was called.
+     */
+    event_source_t* GetEventSource()
+    {
+        return &source;
+    }
+
+    static constexpr eventflags_t LIS3DH_GESTURE_PENDING = 1;
+
+private:
+    static void InterruptRaised(void* arg);
+
+    LIS3DHDriver* devp = nullptr;
+    SpiBus* bus = nullptr;
+    ioline_t line = 0;
+    event_source_t source;
+};
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
+
+#endif /* LIS3DH_GESTURES_HPP */
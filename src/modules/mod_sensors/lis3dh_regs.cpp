@@ -0,0 +1,94 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "lis3dh_regs.hpp"
+
+#if MOD_SENSORS
+
+namespace blinky
+{
+
+/*===========================================================================*/
+/* Local variables                                                           */
+/*===========================================================================*/
+
+/* DMA buffers, guarded by the bus. */
+static uint8_t txbuf[2];
+static uint8_t rxbuf[2];
+
+/* CTRL_REG1 ODR field values, normal and high resolution mode. */
+static const struct
+{
+    uint16_t hz;
+    uint8_t odr;
+} dataRates[] =
+{
+    {1, 0x1},
+    {10, 0x2},
+    {25, 0x3},
+    {50, 0x4},
+    {100, 0x5},
+    {200, 0x6},
+    {400, 0x7},
+};
+
+/*===========================================================================*/
+/* Exported functions                                                        */
+/*===========================================================================*/
+
+uint8_t Lis3dhReadRegister(LIS3DHDriver* devp, SpiBus* bus, uint8_t reg)
+{
+    SPIDriver* spip = bus->Acquire(devp->config->spicfg);
+    txbuf[0] = reg | LIS3DH_SPI_READ;
+    spiSelect(spip);
+    spiExchange(spip, 2, txbuf, rxbuf);
+    spiUnselect(spip);
+    uint8_t value = rxbuf[1];
+    bus->Release();
+
+    return value;
+}
+
+void Lis3dhWriteRegister(LIS3DHDriver* devp, SpiBus* bus, uint8_t reg,
+        uint8_t value)
+{
+    SPIDriver* spip = bus->Acquire(devp->config->spicfg);
+    txbuf[0] = reg;
+    txbuf[1] = value;
+    spiSelect(spip);
+    spiSend(spip, 2, txbuf);
+    spiUnselect(spip);
+    bus->Release();
+}
+
+void Lis3dhSetDataRate(LIS3DHDriver* devp, SpiBus* bus, uint16_t hz)
+{
+    for (const auto& rate : dataRates)
+    {
+        if (rate.hz == hz)
+        {
+            uint8_t ctrl1 = Lis3dhReadRegister(devp, bus, LIS3DH_REG_CTRL1);
+            ctrl1 = (ctrl1 & ~LIS3DH_CTRL1_ODR_MASK) |
+                    (rate.odr << LIS3DH_CTRL1_ODR_SHIFT);
+            Lis3dhWriteRegister(devp, bus, LIS3DH_REG_CTRL1, ctrl1);
+            return;
+        }
+    }
+
+    chDbgAssert(false, "unsupported data rate");
+}
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
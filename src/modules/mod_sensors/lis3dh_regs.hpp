@@ -0,0 +1,117 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef LIS3DH_REGS_HPP
+#define LIS3DH_REGS_HPP
+
+#include "target_cfg.h"
+
+#if MOD_SENSORS
+
+#include "qhal.h"
+#include "lis3dh.h"
+#include "spi_bus.hpp"
+
+#include <cstdint>
+
+/*===========================================================================*/
+/* Constants                                                                 */
+/*===========================================================================*/
+
+/*
+ * LIS3DH registers the lis3dh driver does not cover.
+ */
+#define LIS3DH_SPI_READ             0x80
+#define LIS3DH_SPI_AUTOINC          0x40
+
+#define LIS3DH_REG_CTRL1            0x20
+#define LIS3DH_REG_CTRL2            0x21
+#define LIS3DH_REG_CTRL3            0x22
+#define LIS3DH_REG_CTRL5            0x24
+#define LIS3DH_REG_CTRL6            0x25
+#define LIS3DH_REG_REFERENCE        0x26
+#define LIS3DH_REG_OUT_X_L          0x28
+#define LIS3DH_REG_FIFO_CTRL        0x2E
+#define LIS3DH_REG_FIFO_SRC         0x2F
+#define LIS3DH_REG_INT1_CFG         0x30
+#define LIS3DH_REG_INT1_SRC         0x31
+#define LIS3DH_REG_INT1_THS         0x32
+#define LIS3DH_REG_INT1_DURATION    0x33
+#define LIS3DH_REG_CLICK_CFG        0x38
+#define LIS3DH_REG_CLICK_SRC        0x39
+#define LIS3DH_REG_CLICK_THS        0x3A
+#define LIS3DH_REG_TIME_LIMIT       0x3B
+#define LIS3DH_REG_TIME_LATENCY     0x3C
+#define LIS3DH_REG_TIME_WINDOW      0x3D
+
+#define LIS3DH_CTRL1_ODR_MASK       0xF0
+#define LIS3DH_CTRL1_ODR_SHIFT      4
+
+#define LIS3DH_CTRL2_HPCLICK        0x04
+#define LIS3DH_CTRL2_HP_IA1         0x01
+
+#define LIS3DH_CTRL3_I1_WTM         0x04
+
+#define LIS3DH_CTRL5_FIFO_EN        0x40
+#define LIS3DH_CTRL5_LIR_INT1       0x08
+
+#define LIS3DH_CTRL6_I2_CLICK       0x80
+#define LIS3DH_CTRL6_I2_IA1         0x40
+
+#define LIS3DH_FIFO_MODE_BYPASS     0x00
+#define LIS3DH_FIFO_MODE_STREAM     0x80
+#define LIS3DH_FIFO_FTH_MASK        0x1F
+
+#define LIS3DH_FIFO_SRC_OVRN        0x40
+#define LIS3DH_FIFO_SRC_FSS_MASK    0x1F
+
+#define LIS3DH_INT_CFG_AOI          0x80
+#define LIS3DH_INT_CFG_ZHIE         0x20
+#define LIS3DH_INT_CFG_ZLIE         0x10
+#define LIS3DH_INT_CFG_YHIE         0x08
+#define LIS3DH_INT_CFG_YLIE         0x04
+#define LIS3DH_INT_CFG_XHIE         0x02
+#define LIS3DH_INT_CFG_XLIE         0x01
+
+#define LIS3DH_INT_SRC_IA           0x40
+
+#define LIS3DH_CLICK_CFG_ALL        0x3F
+
+#define LIS3DH_CLICK_SRC_IA         0x40
+#define LIS3DH_CLICK_SRC_DCLICK     0x20
+#define LIS3DH_CLICK_SRC_SCLICK     0x10
+
+#define LIS3DH_CLICK_THS_LIR        0x80
+
+namespace blinky
+{
+
+/**
+ * @brief   Synchronous register access, takes the bus for each access.
+ */
+uint8_t Lis3dhReadRegister(LIS3DHDriver* devp, SpiBus* bus, uint8_t reg);
+void Lis3dhWriteRegister(LIS3DHDriver* devp, SpiBus* bus, uint8_t reg,
+        uint8_t value);
+
+/**
+ * @brief   Changes the output data rate.
+ * @param[in] hz    1, 10, 25, 50, 100, 200 or 400.
+ */
+void Lis3dhSetDataRate(LIS3DHDriver* devp, SpiBus* bus, uint16_t hz);
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
+
+#endif /* LIS3DH_REGS_HPP */
@@ -16,13 +16,44 @@
 #include "qhal.h"
 
 #include "lis3dh.h"
-
-#include <array>
+#include "motion_channel.hpp"
+#include "lis3dh_fifo.hpp"
+#include "spi_bus.hpp"
+#include "motion_pipeline.hpp"
+#include "lis3dh_gestures.hpp"
+#include "cyclecount.h"
+#include "profile.h"
+#include "startup.h"
+#include "lis3dh_regs.hpp"
+#include "standby.h"
 
 namespace blinky
 {
 template <>
-ModuleSensors ModuleSensorsSingelton::instance = blinky::ModuleSensors();
+ModuleSensors ModuleSensorsSingelton::instance MOD_SENSORS_SECTION = blinky::ModuleSensors();
+
+MotionChannel motionChannel;
+
+const MotionPipeline::Config ModuleSensors::pipelineConfig =
+{
+    {
+        MOD_SENSORS_MOVING_ODR,
+        MOD_SENSORS_MOVING_WATERMARK,
+        &MOD_SENSORS_MOVING_LOWPASS,
+        MOD_SENSORS_MOVING_GRAVITY_SHIFT,
+    },
+    {
+        MOD_SENSORS_STILL_ODR,
+        MOD_SENSORS_STILL_WATERMARK,
+        &MOD_SENSORS_STILL_LOWPASS,
+        MOD_SENSORS_STILL_GRAVITY_SHIFT,
+    },
+    MOD_SENSORS_MOVE_THRESHOLD,
+    MOD_SENSORS_STILL_THRESHOLD,
+    TIME_I2MS(MOD_SENSORS_STILL_TIME),
+    TIME_I2MS(MOD_SENSORS_STANDBY_TIME),
+    STM32_HCLK,
+};
 
 /**
  * @brief
@@ -30,7 +61,7 @@ ModuleSensors ModuleSensorsSingelton::instance = blinky::ModuleSensors();
 
 void ModuleSensors::Init()
 {
-    watchdog_register(WATCHDOG_MOD_SENSORS);
+    watchdog_register(WATCHDOG_MOD_SENSORS, MOD_SENSORS_WATCHDOG_DEADLINE);
 }
 
 void ModuleSensors::Start()
@@ -46,18 +77,119 @@ void ModuleSensors::Shutdown()
 void ModuleSensors::ThreadMain()
 {
     chRegSetThreadName("sensors");
+    fifo.Start(&lis3dh, &spiBus1, MOD_SENSORS_FIFO_LINE,
+            MOD_SENSORS_MOVING_WATERMARK);
+    gestures.Start(&lis3dh, &spiBus1, MOD_SENSORS_GESTURE_LINE);
+    SetMotionState(MotionState::Moving);
+    chEvtRegisterMaskWithFlags(fifo.GetEventSource(), &drainListener,
+            EVENT_MASK(0), Lis3dhFifo::LIS3DH_FIFO_DRAINED);
+    chEvtRegisterMaskWithFlags(fifo.GetEventSource(), &watermarkListener,
+            EVENT_MASK(1), Lis3dhFifo::LIS3DH_FIFO_WATERMARK);
+    chEvtRegisterMask(gestures.GetEventSource(), &gestureListener,
+            EVENT_MASK(2));
+    startup_ready(STARTUP_MOD_SENSORS);
     while (!chibios_rt::BaseThread::shouldTerminate())
     {
         watchdog_reload(WATCHDOG_MOD_SENSORS);
 
-        std::array<int32_t, LIS3DH_NUMBER_OF_AXES> accelData;;
-        lis3dhReadRaw(&lis3dh, accelData.data());
+        eventmask_t events = EVENT_MASK(1);
+        if (!fifo.IsAboveWatermark())
+        {
+            events = chEvtWaitAnyTimeout(EVENT_MASK(1) | EVENT_MASK(2),
+                    MOD_SENSORS_FIFO_TIMEOUT);
+        }
+
+        if (events & EVENT_MASK(2))
+        {
+            PublishGestures();
+            if (!(events & EVENT_MASK(1)))
+                continue;
+        }
+
+        /* Drained on timeout as well, in case an edge got lost. */
+        ReadBatch();
+    }
+    chEvtUnregister(gestures.GetEventSource(), &gestureListener);
+    chEvtUnregister(fifo.GetEventSource(), &watermarkListener);
+    chEvtUnregister(fifo.GetEventSource(), &drainListener);
+    gestures.Stop();
+    fifo.Stop();
+#if STANDBY_ENABLE
+    if (standby_requested())
+        gestures.ArmWakeup();
+#endif /* STANDBY_ENABLE */
+}
 
-        int16_t temp = 0;
-        lis3dhReadTemp(&lis3dh, &temp);
+void ModuleSensors::ReadBatch()
+{
+    /* A synchronous drain: the thread blocks until the DMA is done and
+       the CPU goes to the other threads meanwhile. Processing the previous
+       batch during the transfer would delay every sample by a whole
+       watermark period to save the few hundred microseconds the DMA
+       takes. A wake-up per watermark plus one per drain remain, 12.5/s
+       moving and 6.25/s still instead of 40/s polling. */
+    /* All samples drained were taken before this. */
+    uint32_t drained = cyclecount_get();
+
+    PROFILE_BEGIN(PROFILE_LIS3DH_DRAIN);
+    fifo.StartDrain();
+    chEvtWaitAny(EVENT_MASK(0));
+    PROFILE_END(PROFILE_LIS3DH_DRAIN);
+
+    size_t count = fifo.Collect(batch.data(), batch.size());
+    if (count == 0)
+        return;
+
+    int16_t temp = 0;
+    PROFILE_BEGIN(PROFILE_LIS3DH_TEMP);
+    spiBus1.Acquire(lis3dh.config->spicfg);
+    lis3dhReadTemp(&lis3dh, &temp);
+    spiBus1.Release();
+    PROFILE_END(PROFILE_LIS3DH_TEMP);
+
+    /* An overrun dropped samples, the grid has to start over. */
+    bool lost = fifo.overruns != overruns;
+    overruns = fifo.overruns;
+
+    MotionState state = pipeline.Process(batch.data(), count, temp, drained,
+            lost);
+    if (state != pipeline.GetState())
+        SetMotionState(state);
+
+#if STANDBY_ENABLE
+    /* Nobody around, the LIS3DH keeps watching while the MCU sleeps. */
+    if (pipeline.IsStandbyDue())
+        standby_request();
+#endif /* STANDBY_ENABLE */
+}
 
-        chibios_rt::BaseThread::sleep(TIME_MS2I(25));
-    }
+void ModuleSensors::SetMotionState(MotionState state)
+{
+    const MotionPipeline::Rate& rate = pipeline.GetRate(state);
+
+    Lis3dhSetDataRate(&lis3dh, &spiBus1, rate.hz);
+    gestures.SetDataRate(rate.hz);
+
+    /* Drops the samples taken at the old rate, so every batch has a
+       single sample period and the timestamps stay evenly spaced. */
+    fifo.SetWatermark(rate.watermark);
+    pipeline.SetState(state, cyclecount_get());
+}
+
+void ModuleSensors::PublishGestures()
+{
+    uint8_t detected = gestures.Read();
+    eventflags_t flags = 0;
+
+    if (detected & Lis3dhGestures::GESTURE_TAP)
+        flags |= MotionChannel::MOTION_CHANNEL_TAP;
+    if (detected & Lis3dhGestures::GESTURE_DOUBLE_TAP)
+        flags |= MotionChannel::MOTION_CHANNEL_DOUBLE_TAP;
+    if (detected & Lis3dhGestures::GESTURE_FREEFALL)
+        flags |= MotionChannel::MOTION_CHANNEL_FREEFALL;
+
+    if (flags != 0)
+        motionChannel.Notify(flags);
 }
 
 } // namespace blinky
@@ -15,6 +15,13 @@
 
 #if MOD_SENSORS
 
+#include "lis3dh_fifo.hpp"
+#include "motion_channel.hpp"
+#include "motion_pipeline.hpp"
+#include "lis3dh_gestures.hpp"
+
+#include <array>
+
 /*===========================================================================*/
 /* Constants                                                                 */
 /*===========================================================================*/
@@ -30,10 +37,132 @@
 #define MOD_SENSORS_THREADPRIO LOWPRIO
 #endif
 
+/* Placement of the module instance, e.g. a faster RAM bank. */
+#ifndef MOD_SENSORS_SECTION
+#define MOD_SENSORS_SECTION
+#endif
+
+/* Longest time between two drains, MOD_SENSORS_FIFO_TIMEOUT plus the
+ * processing. */
+#ifndef MOD_SENSORS_WATCHDOG_DEADLINE
+#define MOD_SENSORS_WATCHDOG_DEADLINE TIME_MS2I(2000)
+#endif
+
+/**
+ * @brief   Output data rate in Hz while the unit is moving.
+ */
+#ifndef MOD_SENSORS_MOVING_ODR
+#define MOD_SENSORS_MOVING_ODR 100
+#endif
+
+/**
+ * @brief   FIFO watermark while moving, 160 ms at 100 Hz.
+ * @note    Leave some headroom below LIS3DH_FIFO_DEPTH for the time it
+ *          takes the sensors thread to react.
+ */
+#ifndef MOD_SENSORS_MOVING_WATERMARK
+#define MOD_SENSORS_MOVING_WATERMARK 16
+#endif
+
+/**
+ * @brief   Low-pass coefficients for MOD_SENSORS_MOVING_ODR.
+ */
+#ifndef MOD_SENSORS_MOVING_LOWPASS
+#define MOD_SENSORS_MOVING_LOWPASS biquadLowpass10Hz100Hz
+#endif
+
+/**
+ * @brief   Time constant of the gravity estimate while moving as a power of
+ *          two of samples, 6 is 0.64 s at 100 Hz.
+ */
+#ifndef MOD_SENSORS_MOVING_GRAVITY_SHIFT
+#define MOD_SENSORS_MOVING_GRAVITY_SHIFT 6
+#endif
+
+/**
+ * @brief   Output data rate in Hz while the unit lies still.
+ */
+#ifndef MOD_SENSORS_STILL_ODR
+#define MOD_SENSORS_STILL_ODR 25
+#endif
+
+/**
+ * @brief   FIFO watermark while still, 320 ms at 25 Hz.
+ */
+#ifndef MOD_SENSORS_STILL_WATERMARK
+#define MOD_SENSORS_STILL_WATERMARK 8
+#endif
+
+/**
+ * @brief   Low-pass coefficients for MOD_SENSORS_STILL_ODR, same cutoff as
+ *          while moving.
+ */
+#ifndef MOD_SENSORS_STILL_LOWPASS
+#define MOD_SENSORS_STILL_LOWPASS biquadLowpass10Hz25Hz
+#endif
+
+/**
+ * @brief   Time constant of the gravity estimate while still, 4 is 0.64 s
+ *          at 25 Hz as well.
+ */
+#ifndef MOD_SENSORS_STILL_GRAVITY_SHIFT
+#define MOD_SENSORS_STILL_GRAVITY_SHIFT 4
+#endif
+
+/**
+ * @brief   Linear acceleration switching to the moving rate, 0.1 g.
+ * @note    Compared against |x| + |y| + |z| of the gravity free samples.
+ */
+#ifndef MOD_SENSORS_MOVE_THRESHOLD
+#define MOD_SENSORS_MOVE_THRESHOLD 1638
+#endif
+
+/**
+ * @brief   Linear acceleration the unit has to stay below to count as
+ *          still, 0.05 g.
+ */
+#ifndef MOD_SENSORS_STILL_THRESHOLD
+#define MOD_SENSORS_STILL_THRESHOLD 819
+#endif
+
+/**
+ * @brief   Time below MOD_SENSORS_STILL_THRESHOLD before the rate drops.
+ */
+#ifndef MOD_SENSORS_STILL_TIME
+#define MOD_SENSORS_STILL_TIME TIME_S2I(5)
+#endif
+
+/**
+ * @brief   Time lying still before the unit goes to standby.
+ * @note    Only with STANDBY_ENABLE, counts from the drop to the still
+ *          rate.
+ */
+#ifndef MOD_SENSORS_STANDBY_TIME
+#define MOD_SENSORS_STANDBY_TIME TIME_S2I(600)
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks                                        */
 /*===========================================================================*/
 
+#if (MOD_SENSORS_MOVING_WATERMARK < 1) || \
+    (MOD_SENSORS_MOVING_WATERMARK >= LIS3DH_FIFO_DEPTH)
+#error "MOD_SENSORS_MOVING_WATERMARK out of range"
+#endif
+
+#if (MOD_SENSORS_STILL_WATERMARK < 1) || \
+    (MOD_SENSORS_STILL_WATERMARK >= LIS3DH_FIFO_DEPTH)
+#error "MOD_SENSORS_STILL_WATERMARK out of range"
+#endif
+
+#if MOD_SENSORS_MOTION_RING_SIZE <= LIS3DH_FIFO_DEPTH
+#error "MOD_SENSORS_MOTION_RING_SIZE must exceed LIS3DH_FIFO_DEPTH"
+#endif
+
+#if MOD_SENSORS_STILL_THRESHOLD > MOD_SENSORS_MOVE_THRESHOLD
+#error "MOD_SENSORS_STILL_THRESHOLD must not exceed MOD_SENSORS_MOVE_THRESHOLD"
+#endif
+
 namespace blinky
 {
 /**
@@ -52,6 +181,24 @@ class ModuleSensors : public qos::ThreadedModule<MOD_SENSORS_THREADSIZE>
   protected:
     tprio_t GetThreadPrio() const override { return MOD_SENSORS_THREADPRIO; };
     void ThreadMain() override;
+
+  private:
+    using MotionState = MotionPipeline::MotionState;
+
+    void ReadBatch();
+    void PublishGestures();
+    void SetMotionState(MotionState state);
+
+    static const MotionPipeline::Config pipelineConfig;
+
+    Lis3dhFifo fifo;
+    Lis3dhGestures gestures;
+    event_listener_t drainListener;
+    event_listener_t watermarkListener;
+    event_listener_t gestureListener;
+    std::array<AccelVector, LIS3DH_FIFO_DEPTH> batch;
+    MotionPipeline pipeline{pipelineConfig, &motionChannel};
+    uint32_t overruns = 0;
 };
 
 typedef qos::Singleton<ModuleSensors> ModuleSensorsSingelton;
@@ -0,0 +1,143 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef MOTION_CHANNEL_HPP
+#define MOTION_CHANNEL_HPP
+
+#include "target_cfg.h"
+
+#if MOD_SENSORS
+
+#include "ch.h"
+
+#include "sample_ring.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/*===========================================================================*/
+/* Pre-compile time settings                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Samples kept for the subscribers, must be a power of two.
+ * @note    One slot stays free, so it must exceed LIS3DH_FIFO_DEPTH for a
+ *          batch drained from a full FIFO to fit.
+ */
+#ifndef MOD_SENSORS_MOTION_RING_SIZE
+#define MOD_SENSORS_MOTION_RING_SIZE 64
+#endif
+
+namespace blinky
+{
+
+/**
+ * @brief   One filtered accelerometer reading.
+ * @note    Axes are LIS3DH counts, 1 g is 16384 at LIS3DH_FS_2G.
+ */
+struct MotionSample
+{
+    /* cyclecount_get() time of the measurement, on a grid of the sample
+       period that runs on across batches, see SampleClock. */
+    uint32_t timestamp;
+    /* Low-pass filtered acceleration including gravity. */
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    /* Acceleration with gravity removed. */
+    int16_t linearX;
+    int16_t linearY;
+    int16_t linearZ;
+    /* Orientation in 1/65536 turns, updated once per FIFO batch. */
+    int16_t pitch;
+    int16_t roll;
+    int16_t temperature;
+};
+
+/**
+ * @brief   Distributes samples from ModuleSensors to any number of
+ *          subscribers.
+ * @details Every subscriber reads the samples in place through its own
+ *          cursor. @p MOTION_CHANNEL_EVENT is broadcast once per batch, so
+ *          subscribers can wake up immediately instead of at their next
+ *          poll. Gestures are broadcast as flags of the same source.
+ */
+class MotionChannel
+{
+    using Ring = SampleRing<MotionSample, MOD_SENSORS_MOTION_RING_SIZE>;
+
+public:
+    using Cursor = Ring::Cursor;
+
+    MotionChannel()
+    {
+        chEvtObjectInit(&source);
+    }
+
+    /**
+     * @brief   Producer side, appends one sample without notifying.
+     */
+    void Write(const MotionSample& sample)
+    {
+        ring.Write(sample);
+    }
+
+    /**
+     * @brief   Producer side, wakes the subscribers after a batch or a
+     *          detected gesture.
+     */
+    void Notify(eventflags_t flags)
+    {
+        chEvtBroadcastFlags(&source, flags);
+    }
+
+    void Subscribe(Cursor* cursor) const
+    {
+        ring.Subscribe(cursor);
+    }
+
+    size_t Peek(Cursor* cursor, const MotionSample** first) const
+    {
+        return ring.Peek(cursor, first);
+    }
+
+    bool Consume(Cursor* cursor, size_t count)
+    {
+        return ring.Consume(cursor, count);
+    }
+
+    event_source_t* GetEventSource()
+    {
+        return &source;
+    }
+
+    /* New samples are available. */
+    static constexpr eventflags_t MOTION_CHANNEL_EVENT = 1;
+    /* Gestures detected by the sensor itself. */
+    static constexpr eventflags_t MOTION_CHANNEL_TAP = 2;
+    static constexpr eventflags_t MOTION_CHANNEL_DOUBLE_TAP = 4;
+    static constexpr eventflags_t MOTION_CHANNEL_FREEFALL = 8;
+
+private:
+    Ring ring;
+    event_source_t source;
+};
+
+extern MotionChannel motionChannel;
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
+
+#endif /* MOTION_CHANNEL_HPP */
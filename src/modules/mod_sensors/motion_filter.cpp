@@ -0,0 +1,254 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "motion_filter.hpp"
+
+#if MOD_SENSORS
+
+/*===========================================================================*/
+/* Local definitions                                                         */
+/*===========================================================================*/
+
+#define BIQUAD_SHIFT                14
+
+/* Binary angles, 65536 per turn. */
+#define ANGLE_45                    8192
+#define ANGLE_90                    16384
+#define ANGLE_180                   32768
+
+/* The stages address the axes as an array. */
+static_assert(sizeof(blinky::AccelVector) == 3 * sizeof(int16_t),
+        "AccelVector must not be padded");
+
+namespace blinky
+{
+
+/*===========================================================================*/
+/* Exported variables                                                        */
+/*===========================================================================*/
+
+/* The coefficients sum up to the same value, unity gain at DC is exact. */
+const BiquadCoeffs biquadLowpass10Hz100Hz =
+{
+    1105,               /* b0 */
+    2210,               /* b1 */
+    1105,               /* b2 */
+    -18727,             /* a1 */
+    6763,               /* a2 */
+};
+
+/* Rounded so the sums match as well, b1 down instead of up. */
+const BiquadCoeffs biquadLowpass10Hz25Hz =
+{
+    10469,              /* b0 */
+    20936,              /* b1 */
+    10469,              /* b2 */
+    18727,              /* a1 */
+    6763,               /* a2 */
+};
+
+/*===========================================================================*/
+/* Local functions                                                           */
+/*===========================================================================*/
+
+static inline int16_t Saturate16(int32_t value)
+{
+    if (value > INT16_MAX)
+        return INT16_MAX;
+    if (value < INT16_MIN)
+        return INT16_MIN;
+    return value;
+}
+
+/*
+ * atan(t) for t = 0..1 in Q15, result in binary angle units. Uses
+ * atan(t) ~ pi/4 t + t (1 - t) (0.2447 + 0.0663 t).
+ */
+static int32_t AtanUnit(int32_t t)
+{
+    int32_t linear = (ANGLE_45 * t) >> 15;
+    int32_t bend = (t * (32768 - t)) >> 15;
+    return linear + ((bend * (2552 + ((691 * t) >> 15))) >> 15);
+}
+
+/*===========================================================================*/
+/* Exported functions                                                        */
+/*===========================================================================*/
+
+uint32_t SquareRoot(uint32_t value)
+{
+    uint32_t result = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > value)
+        bit >>= 2;
+
+    while (bit != 0)
+    {
+        if (value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return result;
+}
+
+void BiquadFilter::Process(AccelVector* samples, size_t count)
+{
+    const BiquadCoeffs& c = *coeffs;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        int16_t* axes = &samples[i].x;
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+            State& s = state[axis];
+            int32_t x0 = axes[axis];
+            int32_t acc = c.b0 * x0 + c.b1 * s.x1 + c.b2 * s.x2 -
+                    c.a1 * s.y1 - c.a2 * s.y2;
+            int32_t y0 = Saturate16((acc + (1 << (BIQUAD_SHIFT - 1))) >>
+                    BIQUAD_SHIFT);
+
+            s.x2 = s.x1;
+            s.x1 = x0;
+            s.y2 = s.y1;
+            s.y1 = y0;
+            axes[axis] = y0;
+        }
+    }
+}
+
+void BiquadFilter::Reset(const AccelVector& input)
+{
+    const int16_t* axes = &input.x;
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        state[axis] = {axes[axis], axes[axis], axes[axis], axes[axis]};
+    }
+}
+
+void GravityFilter::Process(const AccelVector* samples, AccelVector* linear,
+        size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const int16_t* in = &samples[i].x;
+        int16_t* out = &linear[i].x;
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+            int32_t& g = state[axis];
+            g += in[axis] - (g >> shift);
+            int32_t gravity = g >> shift;
+            out[axis] = Saturate16(in[axis] - gravity);
+        }
+    }
+}
+
+void GravityFilter::Reset(const AccelVector& gravity)
+{
+    const int16_t* axes = &gravity.x;
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        state[axis] = static_cast<int32_t>(axes[axis]) * (1 << shift);
+    }
+}
+
+void GravityFilter::SetShift(uint8_t timeShift)
+{
+    for (int32_t& g : state)
+    {
+        if (timeShift > shift)
+            g *= 1 << (timeShift - shift);
+        else
+            g >>= shift - timeShift;
+    }
+    shift = timeShift;
+}
+
+AccelVector GravityFilter::GetGravity() const
+{
+    return {
+        static_cast<int16_t>(state[0] >> shift),
+        static_cast<int16_t>(state[1] >> shift),
+        static_cast<int16_t>(state[2] >> shift),
+    };
+}
+
+int16_t Atan2(int32_t y, int32_t x)
+{
+    uint32_t ax = (x < 0) ? -x : x;
+    uint32_t ay = (y < 0) ? -y : y;
+    int32_t angle;
+
+    if (ax == 0 && ay == 0)
+        return 0;
+
+    /* Fold into the first octant so the ratio stays within 0..1. */
+    if (ay <= ax)
+        angle = AtanUnit((ay << 15) / ax);
+    else
+        angle = ANGLE_90 - AtanUnit((ax << 15) / ay);
+
+    if (x < 0)
+        angle = ANGLE_180 - angle;
+    if (y < 0)
+        angle = -angle;
+
+    /* 180 degrees wraps to -180, which is the same direction. */
+    return static_cast<int16_t>(angle);
+}
+
+Orientation EstimateOrientation(const AccelVector& gravity)
+{
+    int32_t y = gravity.y;
+    int32_t z = gravity.z;
+
+    /* Both squares reach 2^30 at -32768, their sum needs 32 bit unsigned. */
+    uint32_t yz = static_cast<uint32_t>(y * y) + static_cast<uint32_t>(z * z);
+
+    Orientation orientation;
+    orientation.pitch = Atan2(-gravity.x, SquareRoot(yz));
+    orientation.roll = Atan2(y, z);
+    return orientation;
+}
+
+void MotionFilter::Process(AccelVector* samples, AccelVector* linear,
+        size_t count)
+{
+    if (count == 0)
+        return;
+
+    /* Start from the first reading instead of ramping up from zero. */
+    if (!primed)
+    {
+        lowpass.Reset(samples[0]);
+        gravity.Reset(samples[0]);
+        primed = true;
+    }
+
+    lowpass.Process(samples, count);
+    gravity.Process(samples, linear, count);
+    orientation = EstimateOrientation(gravity.GetGravity());
+}
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
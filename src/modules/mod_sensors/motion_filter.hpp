@@ -0,0 +1,208 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef MOTION_FILTER_HPP
+#define MOTION_FILTER_HPP
+
+#include "target_cfg.h"
+
+#if MOD_SENSORS
+
+#include "accel_vector.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace blinky
+{
+
+/*
+ * All stages work in place on whole FIFO batches and use integer
+ * arithmetic only, the M0 has neither an FPU nor a divider.
+ */
+
+/**
+ * @brief   Biquad coefficients in Q2.14, a0 is normalized to 1.
+ */
+struct BiquadCoeffs
+{
+    int32_t b0;
+    int32_t b1;
+    int32_t b2;
+    int32_t a1;
+    int32_t a2;
+};
+
+/**
+ * @brief   2nd order Butterworth low-pass, 10 Hz at 100 Hz sample rate.
+ */
+extern const BiquadCoeffs biquadLowpass10Hz100Hz;
+
+/**
+ * @brief   2nd order Butterworth low-pass, 10 Hz at 25 Hz sample rate.
+ */
+extern const BiquadCoeffs biquadLowpass10Hz25Hz;
+
+/**
+ * @brief   Direct form I biquad applied to all three axes.
+ */
+class BiquadFilter
+{
+public:
+    explicit BiquadFilter(const BiquadCoeffs& initial) : coeffs(&initial)
+    {
+    }
+
+    /**
+     * @brief   Switches the coefficients without a glitch.
+     * @details Direct form I keeps past inputs and outputs only, which do
+     *          not depend on the coefficients.
+     */
+    void SetCoeffs(const BiquadCoeffs& next)
+    {
+        coeffs = &next;
+    }
+
+    void Process(AccelVector* samples, size_t count);
+
+    /**
+     * @brief   Settles the filter on a constant input.
+     */
+    void Reset(const AccelVector& input);
+
+private:
+    struct State
+    {
+        int32_t x1;
+        int32_t x2;
+        int32_t y1;
+        int32_t y2;
+    };
+
+    const BiquadCoeffs* coeffs;
+    std::array<State, 3> state = {};
+};
+
+/**
+ * @brief   Splits acceleration into gravity and linear acceleration.
+ * @details Gravity is tracked by a first order low-pass, the linear
+ *          acceleration is the complementary high-pass.
+ */
+class GravityFilter
+{
+public:
+    /**
+     * @param[in] timeShift time constant as a power of two of samples,
+     *                      6 is 0.64 s at 100 Hz
+     */
+    explicit GravityFilter(uint8_t timeShift) : shift(timeShift)
+    {
+    }
+
+    /**
+     * @brief   Changes the time constant, e.g. along with the sample rate.
+     * @details The state is rescaled, the gravity estimate is kept.
+     */
+    void SetShift(uint8_t timeShift);
+
+    /**
+     * @brief   Writes the acceleration without gravity to @p linear.
+     */
+    void Process(const AccelVector* samples, AccelVector* linear,
+            size_t count);
+    void Reset(const AccelVector& gravity);
+
+    AccelVector GetGravity() const;
+
+private:
+    uint8_t shift;
+    /* Gravity scaled by 2^shift. */
+    std::array<int32_t, 3> state = {};
+};
+
+/**
+ * @brief   Orientation in binary angle units, 65536 per turn.
+ */
+struct Orientation
+{
+    int16_t pitch;
+    int16_t roll;
+};
+
+/**
+ * @brief   floor(sqrt(value)).
+ */
+uint32_t SquareRoot(uint32_t value);
+
+/**
+ * @brief   atan2(y, x) in binary angle units, max error about 0.1 degree.
+ * @note    Both arguments must be within +-65535.
+ */
+int16_t Atan2(int32_t y, int32_t x);
+
+/**
+ * @brief   Pitch and roll from a gravity vector.
+ */
+Orientation EstimateOrientation(const AccelVector& gravity);
+
+/**
+ * @brief   The filter chain of ModuleSensors.
+ * @details Smoothes the samples with a low-pass biquad, removes gravity
+ *          and estimates the orientation from the gravity left over at the
+ *          end of the batch. Gravity changes slowly, so one estimate per
+ *          batch is enough and saves the divisions per sample.
+ */
+class MotionFilter
+{
+public:
+    MotionFilter(const BiquadCoeffs& coeffs, uint8_t gravityShift)
+        : lowpass(coeffs), gravity(gravityShift)
+    {
+    }
+
+    /**
+     * @brief   Adapts both stages to a new sample rate.
+     * @details The low-pass keeps its cutoff and gravity its time constant
+     *          in seconds, both are specific to the rate.
+     */
+    void SetDataRate(const BiquadCoeffs& coeffs, uint8_t gravityShift)
+    {
+        lowpass.SetCoeffs(coeffs);
+        gravity.SetShift(gravityShift);
+    }
+
+    /**
+     * @brief   Filters @p samples in place, writes the linear acceleration
+     *          to @p linear.
+     */
+    void Process(AccelVector* samples, AccelVector* linear, size_t count);
+
+    Orientation GetOrientation() const
+    {
+        return orientation;
+    }
+
+private:
+    BiquadFilter lowpass;
+    GravityFilter gravity;
+    Orientation orientation = {};
+    bool primed = false;
+};
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
+
+#endif /* MOTION_FILTER_HPP */
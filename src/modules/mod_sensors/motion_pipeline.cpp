@@ -0,0 +1,110 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "motion_pipeline.hpp"
+
+#if MOD_SENSORS
+
+#include <cstdlib>
+
+namespace blinky
+{
+
+/*===========================================================================*/
+/* Exported functions                                                        */
+/*===========================================================================*/
+
+void MotionPipeline::SetState(MotionState next, uint32_t emptied)
+{
+    const Rate& rate = GetRate(next);
+
+    filter.SetDataRate(*rate.lowpass, rate.gravityShift);
+    sampleClock.Start(emptied, config->clock / rate.hz);
+    quietSamples = 0;
+    state = next;
+}
+
+MotionPipeline::MotionState MotionPipeline::Process(AccelVector* samples,
+        size_t count, int16_t temperature, uint32_t drained, bool lost)
+{
+    if (count > linear.size())
+        count = linear.size();
+    if (count == 0)
+        return state;
+
+    uint32_t timestamp = sampleClock.Advance(drained, count, lost);
+    uint32_t period = sampleClock.GetPeriod();
+
+    filter.Process(samples, linear.data(), count);
+    Orientation orientation = filter.GetOrientation();
+
+    int32_t activity = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        MotionSample sample;
+        sample.timestamp = timestamp + i * period;
+        sample.x = samples[i].x;
+        sample.y = samples[i].y;
+        sample.z = samples[i].z;
+        sample.linearX = linear[i].x;
+        sample.linearY = linear[i].y;
+        sample.linearZ = linear[i].z;
+        sample.pitch = orientation.pitch;
+        sample.roll = orientation.roll;
+        sample.temperature = temperature;
+        channel->Write(sample);
+
+        int32_t magnitude = std::abs(linear[i].x) + std::abs(linear[i].y) +
+                std::abs(linear[i].z);
+        if (magnitude > activity)
+            activity = magnitude;
+
+        /* Saturates before the product in HasBeenQuietFor() overflows. */
+        if (magnitude >= config->stillThreshold)
+            quietSamples = 0;
+        else if (quietSamples < UINT32_MAX / 1000)
+            ++quietSamples;
+    }
+    channel->Notify(MotionChannel::MOTION_CHANNEL_EVENT);
+
+    /* Wake up at once, but calm down only after a while. */
+    if (state == MotionState::Still)
+    {
+        if (activity >= config->moveThreshold)
+            return MotionState::Moving;
+    }
+    else if (HasBeenQuietFor(config->stillTime))
+    {
+        return MotionState::Still;
+    }
+    return state;
+}
+
+bool MotionPipeline::IsStandbyDue() const
+{
+    return state == MotionState::Still && HasBeenQuietFor(config->standbyTime);
+}
+
+/*===========================================================================*/
+/* Local functions                                                           */
+/*===========================================================================*/
+
+bool MotionPipeline::HasBeenQuietFor(uint32_t ms) const
+{
+    return quietSamples * 1000 >= ms * GetRate(state).hz;
+}
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
@@ -0,0 +1,133 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef MOTION_PIPELINE_HPP
+#define MOTION_PIPELINE_HPP
+
+#include "target_cfg.h"
+
+#if MOD_SENSORS
+
+#include "accel_vector.hpp"
+#include "motion_channel.hpp"
+#include "motion_filter.hpp"
+#include "sample_clock.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace blinky
+{
+
+/**
+ * @brief   What ModuleSensors does with a drained FIFO batch.
+ * @details Filters and timestamps the samples, hands them to the motion
+ *          channel and decides on the data rate. It knows neither the
+ *          sensor nor the kernel, the module owns the FIFO and applies the
+ *          rate. Host tests replay traces through it the same way.
+ */
+class MotionPipeline
+{
+public:
+    enum class MotionState
+    {
+        Still,
+        Moving,
+    };
+
+    /**
+     * @brief   Sensor and filter settings of one motion state.
+     */
+    struct Rate
+    {
+        uint16_t hz;
+        uint8_t watermark;
+        const BiquadCoeffs* lowpass;
+        uint8_t gravityShift;
+    };
+
+    struct Config
+    {
+        Rate moving;
+        Rate still;
+        /* Compared against |x| + |y| + |z| of the linear acceleration. */
+        int32_t moveThreshold;
+        int32_t stillThreshold;
+        /* Milliseconds below stillThreshold before the rate drops. */
+        uint32_t stillTime;
+        /* Milliseconds below stillThreshold before standby is due,
+           counting from the drop to the still rate. */
+        uint32_t standbyTime;
+        /* Timestamp units per second. */
+        uint32_t clock;
+    };
+
+    MotionPipeline(const Config& cfg, MotionChannel* output)
+        : config(&cfg), channel(output),
+          filter(*cfg.moving.lowpass, cfg.moving.gravityShift)
+    {
+    }
+
+    /**
+     * @brief   Starts over in @p next.
+     * @details Call after applying GetRate() of @p next to the sensor.
+     * @param[in] emptied   time the FIFO was emptied, in timestamp units
+     */
+    void SetState(MotionState next, uint32_t emptied);
+
+    /**
+     * @brief   Filters and publishes one batch, oldest sample first.
+     * @details Samples beyond LIS3DH_FIFO_DEPTH are ignored.
+     * @param[in] drained   time the drain started
+     * @param[in] lost      the FIFO overflowed before this batch
+     * @return  The state the sensor should run in, call SetState() if it
+     *          differs from GetState().
+     */
+    MotionState Process(AccelVector* samples, size_t count,
+            int16_t temperature, uint32_t drained, bool lost);
+
+    MotionState GetState() const
+    {
+        return state;
+    }
+
+    const Rate& GetRate(MotionState which) const
+    {
+        return (which == MotionState::Still) ? config->still : config->moving;
+    }
+
+    /**
+     * @brief   The unit lay still for Config::standbyTime.
+     */
+    bool IsStandbyDue() const;
+
+private:
+    bool HasBeenQuietFor(uint32_t ms) const;
+
+    const Config* config;
+    MotionChannel* channel;
+    MotionFilter filter;
+    SampleClock sampleClock;
+    std::array<AccelVector, LIS3DH_FIFO_DEPTH> linear;
+    MotionState state = MotionState::Moving;
+    /* Samples since the last one above Config::stillThreshold. */
+    uint32_t quietSamples = 0;
+};
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
+
+#endif /* MOTION_PIPELINE_HPP */
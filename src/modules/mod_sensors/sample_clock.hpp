@@ -0,0 +1,118 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SAMPLE_CLOCK_HPP
+#define SAMPLE_CLOCK_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace blinky
+{
+
+/**
+ * @brief   Timestamps FIFO samples on an evenly spaced grid.
+ * @details The sensor samples on its own oscillator, a drain only tells
+ *          that the newest sample was taken within the sample period
+ *          before it. Every sample advances the grid by one period, so the
+ *          spacing stays the same across batches no matter when the
+ *          thread got to drain. The grid follows the drain times slowly,
+ *          a quarter of the error corrects the phase and a small share the
+ *          period, which absorbs the tolerance of the sensor clock.
+ * @note    Times are in any 32 bit wrapping unit, e.g. cyclecount_get().
+ */
+class SampleClock
+{
+public:
+    /**
+     * @brief   Starts a new grid, e.g. after a rate change.
+     * @details The deviation of the sensor clock learned so far is kept,
+     *          it is the same at every rate.
+     * @param[in] emptied       time the FIFO was emptied
+     * @param[in] nominalPeriod sample period at the data rate
+     */
+    void Start(uint32_t emptied, uint32_t nominalPeriod)
+    {
+        uint32_t adjusted = nominalPeriod;
+        if (nominal != 0)
+        {
+            adjusted = static_cast<uint64_t>(nominalPeriod) * period /
+                    nominal;
+        }
+
+        nominal = nominalPeriod;
+        period = adjusted;
+        /* The first sample follows within one period. */
+        next = emptied + adjusted / 2;
+    }
+
+    /**
+     * @brief   Timestamps a batch of @p count samples.
+     * @param[in] drained   time the drain started
+     * @param[in] lost      samples were lost before the batch, the grid is
+     *                      anchored anew at @p drained
+     * @return  Timestamp of the oldest sample, the others follow at
+     *          GetPeriod() intervals.
+     */
+    uint32_t Advance(uint32_t drained, size_t count, bool lost)
+    {
+        /* The newest sample is expected half a period before the drain. */
+        uint32_t newest = drained - period / 2;
+
+        if (lost)
+            next = newest - (count - 1) * period;
+
+        int32_t error = static_cast<int32_t>(newest -
+                (next + (count - 1) * period));
+
+        /* Within 1/8 of the nominal period, beyond the sensor tolerance. */
+        int32_t margin = nominal / 8;
+        int32_t offset = static_cast<int32_t>(period - nominal) +
+                error / static_cast<int32_t>(16 * count);
+        if (offset > margin)
+            offset = margin;
+        if (offset < -margin)
+            offset = -margin;
+        period = nominal + offset;
+
+        uint32_t first = next;
+        next += count * period;
+
+        /* Bounded, so the next batch never starts before this one ends. */
+        int32_t limit = period / 2;
+        int32_t phase = error / 4;
+        if (phase > limit)
+            phase = limit;
+        if (phase < -limit)
+            phase = -limit;
+        next += phase;
+
+        return first;
+    }
+
+    uint32_t GetPeriod() const
+    {
+        return period;
+    }
+
+private:
+    uint32_t nominal = 0;
+    uint32_t period = 0;
+    /* Timestamp of the next sample. */
+    uint32_t next = 0;
+};
+
+} // namespace blinky
+
+#endif /* SAMPLE_CLOCK_HPP */
@@ -0,0 +1,120 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SAMPLE_RING_HPP
+#define SAMPLE_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace blinky
+{
+
+/**
+ * @brief   Single producer ring buffer with any number of readers.
+ * @details The producer never blocks and never looks at its readers, it
+ *          simply overwrites the oldest item. Every reader owns a
+ *          @p Cursor and reads the items in place. A reader that falls
+ *          behind loses the oldest items and finds them counted in
+ *          @p Cursor::overruns.
+ * @note    One slot is always reserved for the write in progress, so at
+ *          most N - 1 items are readable.
+ */
+template <typename T, size_t N>
+class SampleRing
+{
+    static_assert((N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+    struct Cursor
+    {
+        uint32_t next = 0;
+        uint32_t overruns = 0;
+    };
+
+    /**
+     * @brief   Producer side, appends one item.
+     */
+    void Write(const T& item)
+    {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        items[head % N] = item;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief   Starts reading at the next item written.
+     */
+    void Subscribe(Cursor* cursor) const
+    {
+        cursor->next = head_.load(std::memory_order_acquire);
+        cursor->overruns = 0;
+    }
+
+    /**
+     * @brief   Returns the oldest unread items without copying them.
+     * @details The run ends at the wrap around, call again after
+     *          Consume() for the rest.
+     * @return  Number of items available at @p *first.
+     */
+    size_t Peek(Cursor* cursor, const T** first) const
+    {
+        uint32_t head = head_.load(std::memory_order_acquire);
+        if (head - cursor->next > N - 1)
+        {
+            cursor->overruns += head - cursor->next - (N - 1);
+            cursor->next = head - (N - 1);
+        }
+
+        size_t index = cursor->next % N;
+        size_t count = head - cursor->next;
+        if (count > N - index)
+            count = N - index;
+
+        *first = &items[index];
+        return count;
+    }
+
+    /**
+     * @brief   Marks @p count items returned by Peek() as read.
+     * @return  false if the producer overwrote some of them meanwhile,
+     *          the lost items are added to @p Cursor::overruns.
+     */
+    bool Consume(Cursor* cursor, size_t count)
+    {
+        uint32_t start = cursor->next;
+        cursor->next += count;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - start > N - 1)
+        {
+            /* Items past the consumed ones are accounted by Peek(). */
+            uint32_t lost = head - start - (N - 1);
+            cursor->overruns += (lost < count) ? lost : count;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::array<T, N> items;
+    std::atomic<uint32_t> head_{0};
+};
+
+} // namespace blinky
+
+#endif /* SAMPLE_RING_HPP */
@@ -0,0 +1,121 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SPI_BUS_HPP
+#define SPI_BUS_HPP
+
+#include "target_cfg.h"
+
+#if MOD_SENSORS
+
+#include "qhal.h"
+#include "clockscale.h"
+
+namespace blinky
+{
+
+/**
+ * @brief   Arbitrates one SPI peripheral between its devices.
+ * @details Each device brings its own configuration, which is applied
+ *          when it acquires the bus. Unlike the HAL mutual exclusion, the
+ *          bus can be handed back from a transfer complete callback, so
+ *          asynchronous transfers do not keep the owner thread busy.
+ *          With clock scaling the baud rate divider is lowered by the
+ *          shift, so devices keep their SCK rate.
+ */
+class SpiBus
+{
+public:
+    explicit SpiBus(SPIDriver* driver) : spip(driver)
+    {
+        chBSemObjectInit(&sem, false);
+#if CLOCKSCALE_ENABLE
+        clockListener.prepare = ClockPrepare;
+        clockListener.complete = ClockComplete;
+        clockListener.arg = this;
+        clockscale_register(&clockListener);
+#endif /* CLOCKSCALE_ENABLE */
+    }
+
+    SPIDriver* Acquire(const SPIConfig* config)
+    {
+        chBSemWait(&sem);
+#if CLOCKSCALE_ENABLE
+        last = config;
+        Apply(clockscale_get_shift());
+#else
+        spiStart(spip, config);
+#endif /* CLOCKSCALE_ENABLE */
+        return spip;
+    }
+
+    void Release()
+    {
+        chBSemSignal(&sem);
+    }
+
+    /**
+     * @brief   Releases the bus from ISR context, e.g. an SPI end callback.
+     */
+    void ReleaseI()
+    {
+        chBSemSignalI(&sem);
+    }
+
+private:
+#if CLOCKSCALE_ENABLE
+    /* The divider saturates at 2, slower clocks also slow down SCK. */
+    void Apply(unsigned shift)
+    {
+        scaled = *last;
+        uint32_t br = (scaled.cr1 & SPI_CR1_BR) >> SPI_CR1_BR_Pos;
+        br = (br > shift) ? br - shift : 0;
+        scaled.cr1 = (scaled.cr1 & ~SPI_CR1_BR) | (br << SPI_CR1_BR_Pos);
+        spiStart(spip, &scaled);
+    }
+
+    /* Keeps the bus until the new clock is applied. */
+    static void ClockPrepare(void* arg)
+    {
+        SpiBus* self = static_cast<SpiBus*>(arg);
+        chBSemWait(&self->sem);
+    }
+
+    static void ClockComplete(void* arg, unsigned shift)
+    {
+        SpiBus* self = static_cast<SpiBus*>(arg);
+        if (self->last != nullptr)
+        {
+            self->Apply(shift);
+        }
+        chBSemSignal(&self->sem);
+    }
+
+    clockscale_listener_t clockListener;
+    const SPIConfig* last = nullptr;
+    SPIConfig scaled;
+#endif /* CLOCKSCALE_ENABLE */
+    SPIDriver* spip;
+    binary_semaphore_t sem;
+};
+
+#if STM32_SPI_USE_SPI1
+extern SpiBus spiBus1;
+#endif /* STM32_SPI_USE_SPI1 */
+
+} // namespace blinky
+
+#endif /* MOD_SENSORS */
+
+#endif /* SPI_BUS_HPP */
@@ -18,6 +18,7 @@
 
 #include "ch_tools.h"
 #include "watchdog.h"
+#include "startup.h"
 #include "module_init_cpp.h"
 
 #include "qhal.h"
@@ -59,6 +60,7 @@ tprio_t ModTestCpp::GetThreadPrio() const
 void ModTestCpp::ThreadMain()
 {
     chRegSetThreadName("mod_test_cpp");
+    startup_ready(STARTUP_MOD_TEST);
 
     //systime_t lastSysTime = chibios_rt::System::getTimeX();
 
@@ -93,7 +95,7 @@ ModTestCpp::~ModTestCpp()
 
 void ModTestCpp::Init()
 {
-    watchdog_register(WATCHDOG_MOD_TEST);
+    watchdog_register(WATCHDOG_MOD_TEST, MOD_TEST_CPP_WATCHDOG_DEADLINE);
 }
 
 /**
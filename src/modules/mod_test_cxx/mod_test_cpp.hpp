@@ -29,6 +29,11 @@
 /* Pre-compile time settings                                                 */
 /*===========================================================================*/
 
+/* The LED toggles every 250 ms. */
+#ifndef MOD_TEST_CPP_WATCHDOG_DEADLINE
+#define MOD_TEST_CPP_WATCHDOG_DEADLINE TIME_MS2I(1000)
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks                                        */
 /*===========================================================================*/
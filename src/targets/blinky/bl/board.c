@@ -50,6 +50,10 @@
  */
 void __early_init(void)
 {
+    /* Decide before anything else, a shelved unit wakes up every few
+     * seconds. */
+    boardStandbyResume();
+
     DBGMCU_TypeDef* dbg = DBGMCU;
 #if !defined(NDEBUG)
     dbg->CR =
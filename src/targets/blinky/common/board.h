@@ -1333,6 +1333,10 @@ extern "C" {
     void boardJumpToApplication(uint32_t address);
     void boardMassErase(void);
     bool boardGetUserButtonState(void);
+    void boardStandby(void);
+    void boardEnterStandby(void);
+    bool boardWakeupMotion(void);
+    void boardStandbyResume(void);
 #ifdef __cplusplus
 }
 #endif
@@ -359,7 +359,7 @@ static const lis3dhConfig lis3dh_cfg = {
   .spip = &SPID1,
   .spicfg = &spicfg,
   .fullscale = LIS3DH_FS_2G,
-  .outputdatarate = LIS3DH_ODR_25HZ,
+  .outputdatarate = LIS3DH_ODR_100HZ,
   .antialiasing = LIS3DH_BW_800HZ,
   .blockdataupdate = LIS3DH_BDU_BLOCKED,
   .temp_cfg = LIS3DH_TEMP_CFG_TEMP_EN | LIS3DH_TEMP_CFG_ADC_EN
@@ -0,0 +1,85 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+
+/*
+ * Standby shared by bootloader and firmware. The LIS3DH lines are no
+ * wake-up pins, so the RTC wakes the MCU periodically and the latched
+ * inertial interrupt on INT2 tells whether the unit was moved meanwhile.
+ * Both work on registers only, they run before the clock and the HAL
+ * are set up.
+ */
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Enters standby, the RTC wakeup timer must be running.
+ * @note    Does not return, waking up resets the MCU.
+ */
+void boardEnterStandby(void)
+{
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+    (void)RCC->APB1ENR;
+    PWR->CR |= PWR_CR_DBP;
+
+    /* LSI is off after the reset, the RTC would stop without it. */
+    RCC->CSR |= RCC_CSR_LSION;
+    while ((RCC->CSR & RCC_CSR_LSIRDY) == 0)
+        ;
+
+    /* A pending wake-up flag would end standby at once. */
+    RTC->ISR &= ~RTC_ISR_WUTF;
+    EXTI->PR = EXTI_PR_PR20;
+    PWR->CR |= PWR_CR_CWUF | PWR_CR_PDDS;
+
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    __DSB();
+    for (;;)
+        __WFI();
+}
+
+/**
+ * @brief   True if the LIS3DH latched a movement.
+ */
+bool boardWakeupMotion(void)
+{
+    RCC->AHBENR |= RCC_AHBENR_GPIOEEN;
+    (void)RCC->AHBENR;
+
+    return (GPIOE->IDR & (1U << GPIOE_INT2)) != 0;
+}
+
+/**
+ * @brief   Goes back to standby if the RTC woke us without a movement.
+ * @details Called first in __early_init(), takes a few microseconds at
+ *          the reset clock. Returns if the boot shall continue, after a
+ *          movement or any reset other than a standby wake-up.
+ */
+void boardStandbyResume(void)
+{
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+    (void)RCC->APB1ENR;
+
+    if ((PWR->CSR & PWR_CSR_SBF) == 0)
+        return;
+    PWR->CR |= PWR_CR_CSBF;
+
+    if (boardWakeupMotion())
+        return;
+
+    boardEnterStandby();
+}
@@ -13,6 +13,10 @@
 */
 
 #include "target_cfg.h"
+#include "cyclecount.h"
+#include "boottime.h"
+#include "clockscale.h"
+#include "standby.h"
 
 #include "nelems.h"
 
@@ -39,6 +43,57 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if CLOCKSCALE_ENABLE && HAL_USE_WS281X
+/*
+ * A frame must not be cut by the change. The DMA of ws281x_cfg feeds one
+ * bit per PWM period, the last one is out with the update event after
+ * the count ran out. A frame of five LEDs takes 150 us, so polling is
+ * fine. No new frame can start, ws281xUpdate() and clockscale_set() are
+ * both called by the effects thread.
+ */
+static void ws281x_clock_prepare(void *arg)
+{
+    PWMDriver *pwmp = arg;
+    const stm32_dma_stream_t *dmastp = STM32_DMA1_STREAM6;
+
+    while (((dmastp->channel->CCR & STM32_DMA_CR_EN) != 0U) &&
+           (dmaStreamGetTransactionSize(dmastp) != 0U))
+    {
+    }
+
+    if ((pwmp->tim->CR1 & STM32_TIM_CR1_CEN) != 0U)
+    {
+        pwmp->tim->SR = ~STM32_TIM_SR_UIF;
+        while ((pwmp->tim->SR & STM32_TIM_SR_UIF) == 0U)
+        {
+        }
+    }
+}
+
+/*
+ * The WS281x bit timing is given in ticks of the PWM frequency, the
+ * prescaler computed by pwmStart() is only right at full clock.
+ */
+static void ws281x_clock_complete(void *arg, unsigned shift)
+{
+    PWMDriver *pwmp = arg;
+    uint32_t clock = pwmp->clock >> shift;
+    uint32_t psc = (clock / pwmp->config->frequency) - 1;
+
+    osalDbgAssert(((psc + 1) * pwmp->config->frequency) == clock,
+            "invalid frequency");
+    pwmp->tim->PSC = psc;
+    pwmp->tim->EGR = STM32_TIM_EGR_UG;
+}
+
+static clockscale_listener_t ws281x_clock_listener =
+{
+    .prepare = ws281x_clock_prepare,
+    .complete = ws281x_clock_complete,
+    .arg = &PWMD1,
+};
+#endif /* CLOCKSCALE_ENABLE && HAL_USE_WS281X */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -50,8 +105,12 @@
  */
 void __early_init(void)
 {
+    cyclecount_init();
+    boottime_begin();
+
     stm32_gpio_init();
     stm32_clock_init();
+    boottime_mark(BOOTTIME_CLOCK_INIT);
 }
 
 /**
@@ -109,6 +168,7 @@ void boardInit(void)
     lis3dhObjectInit(&lis3dh);
 #endif /* HAL_USE_LIS3DH */
 
+    boottime_mark(BOOTTIME_BOARD_INIT);
 }
 
 /**
@@ -121,6 +181,11 @@ void boardStart(void)
     wdgStart(&WDGD1, &WDGD1_cfg);
 #endif /* HAL_USE_WDG */
 
+    /* The wakeup timer keeps running after standby. */
+#if HAL_USE_RTC
+    rtcSTM32SetPeriodicWakeup(&RTCD1, NULL);
+#endif /* HAL_USE_RTC */
+
     /* Start status LED driver */
 #if HAL_USE_LED
     ledStart(&led_green, &led_green_cfg);
@@ -129,6 +194,9 @@ void boardStart(void)
 
 #if HAL_USE_WS281X
     ws281xStart(&ws281x, &ws281x_cfg);
+#if CLOCKSCALE_ENABLE
+    clockscale_register(&ws281x_clock_listener);
+#endif /* CLOCKSCALE_ENABLE */
 #endif /* HAL_USE_WS281X */
 
 #if HAL_USE_LIS3DH
@@ -188,6 +256,10 @@ void boardStop(void)
 #endif /* HAL_USE_FLASH */
 
 #if HAL_USE_LIS3DH
+#if STANDBY_ENABLE
+    /* Armed by ModuleSensors, wakes the unit from standby. */
+    if (!standby_requested())
+#endif /* STANDBY_ENABLE */
     lis3dhStop(&lis3dh);
 #endif /* HAL_USE_LIS3DH */
 
@@ -219,3 +291,18 @@ void boardReset(void)
     NVIC_SystemReset();
 }
 
+#if HAL_USE_RTC
+/**
+ * @brief   Enters standby until the unit is moved.
+ * @details The RTC wakes the MCU every RTCWakeup_cfg interval, the
+ *          bootloader then checks the LIS3DH and either boots or goes
+ *          back to standby, see boardStandbyResume().
+ * @note    Call after boardStop(), the LIS3DH must be armed by then.
+ */
+void boardStandby(void)
+{
+    rtcSTM32SetPeriodicWakeup(&RTCD1, &RTCWakeup_cfg);
+    boardEnterStandby();
+}
+#endif /* HAL_USE_RTC */
+
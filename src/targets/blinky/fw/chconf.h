@@ -49,7 +49,13 @@
  * @details Frequency of the system timer that drives the system ticks. This
  *          setting also defines the system tick time unit.
  */
+/* The tickless profile (make TICKLESS=1) only wakes up for due timers,
+ * so a finer time base costs nothing. */
+#if defined(KERNEL_TICKLESS)
+#define CH_CFG_ST_FREQUENCY                 10000
+#else
 #define CH_CFG_ST_FREQUENCY                 1000
+#endif /* defined(KERNEL_TICKLESS) */
 
 /**
  * @brief   Time intervals data size.
@@ -71,7 +77,11 @@
  *          The value one is not valid, timeouts are rounded up to
  *          this value.
  */
+#if defined(KERNEL_TICKLESS)
+#define CH_CFG_ST_TIMEDELTA                 2
+#else
 #define CH_CFG_ST_TIMEDELTA                 0
+#endif /* defined(KERNEL_TICKLESS) */
 
 /** @} */
 
@@ -249,7 +259,7 @@
  * @note    The default is @p TRUE.
  * @note    Requires @p CH_CFG_USE_EVENTS.
  */
-#define CH_CFG_USE_EVENTS_TIMEOUT           FALSE
+#define CH_CFG_USE_EVENTS_TIMEOUT           TRUE
 
 /**
  * @brief   Synchronous Messages APIs.
@@ -279,7 +289,7 @@
  * @note    The default is @p TRUE.
  * @note    Requires @p CH_CFG_USE_SEMAPHORES.
  */
-#define CH_CFG_USE_MAILBOXES                FALSE
+#define CH_CFG_USE_MAILBOXES                TRUE
 
 /**
  * @brief   Core Memory Manager APIs.
@@ -309,7 +319,7 @@
  *
  * @note    The default is @p TRUE.
  */
-#define CH_CFG_USE_MEMPOOLS                 FALSE
+#define CH_CFG_USE_MEMPOOLS                 TRUE
 
 /**
  * @brief  Objects FIFOs APIs.
@@ -514,6 +524,11 @@
  */
 /*===========================================================================*/
 
+/* Prototypes of the idle hooks below. */
+#if !defined(_FROM_ASM_)
+#include "idlestat.h"
+#endif /* !defined(_FROM_ASM_) */
+
 /**
  * @brief   System structure extension.
  * @details User fields added to the end of the @p ch_system_t structure.
@@ -585,7 +600,7 @@
  * @note    This macro can be used to activate a power saving mode.
  */
 #define CH_CFG_IDLE_ENTER_HOOK() {                                          \
-  /* Idle-enter code here.*/                                                \
+  idlestat_enter();                                                         \
 }
 
 /**
@@ -595,7 +610,7 @@
  * @note    This macro can be used to deactivate a power saving mode.
  */
 #define CH_CFG_IDLE_LEAVE_HOOK() {                                          \
-  /* Idle-leave code here.*/                                                \
+  idlestat_leave();                                                         \
 }
 
 /**
@@ -603,7 +618,7 @@
  * @details This hook is continuously invoked by the idle thread loop.
  */
 #define CH_CFG_IDLE_LOOP_HOOK() {                                           \
-  /* Idle loop code here.*/                                                 \
+  idlestat_wakeup();                                                        \
 }
 
 /**
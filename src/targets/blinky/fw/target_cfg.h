@@ -28,6 +28,51 @@
 #define MOD_EFFECTS                 TRUE
 #define MOD_SENSORS                 TRUE
 
+/* Thread load and stack report, relies on the kernel debug options.
+ * Threads profiling is not available in the tickless kernel. */
+#if !defined(NDEBUG) && !defined(KERNEL_TICKLESS)
+#define MOD_MONITOR                 TRUE
+#endif
+
+/* Timing zones on the hot paths, see profile.h. */
+#if !defined(NDEBUG)
+#define PROFILE_ENABLE              TRUE
+#endif
+
+/*
+ * Code executed from SRAM instead of flash with wait states. The
+ * .ram0_init.ramtext input section is part of .ram0_init in rules.ld and
+ * copied from flash at startup. long_call because SRAM is out of BL range.
+ */
+#define RAM_SECTION_TEXT            __attribute__((section(".ram0_init.ramtext"), noinline, long_call))
+
+/* HCLK follows the render load, 48, 24 or 12 MHz. All three keep the
+ * 12 MHz WS281x tick and the SysTick rate exact. */
+#define CLOCKSCALE_ENABLE           TRUE
+
+/* Standby after MOD_SENSORS_STANDBY_TIME lying still, a movement wakes
+ * the unit again. */
+#define STANDBY_ENABLE              TRUE
+
+/* Render loop of the effects module, NORAMTEXT keeps it in flash. */
+#if !defined(NORAMTEXT)
+#define MOD_EFFECTS_RAMTEXT         RAM_SECTION_TEXT
+#endif
+
+/* LIS3DH INT1, signals the FIFO watermark. */
+#define MOD_SENSORS_FIFO_LINE       LINE_INT1
+
+/* LIS3DH INT2, signals taps and free fall. */
+#define MOD_SENSORS_GESTURE_LINE    LINE_INT2
+
+/* Motion log, make LOGGER=1. Takes about 4 KiB of RAM. The EE partition
+ * is formatted with FAT12 on first use and holds a few seconds of moving
+ * samples, enough to record a gesture. */
+#if defined(LOGGER_ENABLE)
+#define MOD_LOGGER                  TRUE
+#define MOD_LOGGER_DEVICE           ((BaseNVMDevice*)&nvm_fee)
+#endif
+
 #define DISPLAY_WIDTH 5
 #define DISPLAY_HEIGHT 1
 #define LEDCOUNT 5
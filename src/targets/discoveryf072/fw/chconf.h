@@ -566,6 +566,11 @@
  */
 /*===========================================================================*/
 
+/* Prototypes of the idle hooks below. */
+#if !defined(_FROM_ASM_)
+#include "idlestat.h"
+#endif /* !defined(_FROM_ASM_) */
+
 /**
  * @brief   System structure extension.
  * @details User fields added to the end of the @p ch_system_t structure.
@@ -637,7 +642,7 @@
  * @note    This macro can be used to activate a power saving mode.
  */
 #define CH_CFG_IDLE_ENTER_HOOK() {                                          \
-  /* Idle-enter code here.*/                                                \
+  idlestat_enter();                                                         \
 }
 
 /**
@@ -647,7 +652,7 @@
  * @note    This macro can be used to deactivate a power saving mode.
  */
 #define CH_CFG_IDLE_LEAVE_HOOK() {                                          \
-  /* Idle-leave code here.*/                                                \
+  idlestat_leave();                                                         \
 }
 
 /**
@@ -655,7 +660,7 @@
  * @details This hook is continuously invoked by the idle thread loop.
  */
 #define CH_CFG_IDLE_LOOP_HOOK() {                                           \
-  /* Idle loop code here.*/                                                 \
+  idlestat_wakeup();                                                        \
 }
 
 /**
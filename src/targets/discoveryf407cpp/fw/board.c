@@ -13,6 +13,8 @@
 */
 
 #include "target_cfg.h"
+#include "cyclecount.h"
+#include "boottime.h"
 
 #include "nelems.h"
 
@@ -50,8 +52,12 @@
  */
 void __early_init(void)
 {
+    cyclecount_init();
+    boottime_begin();
+
     stm32_gpio_init();
     stm32_clock_init();
+    boottime_mark(BOOTTIME_CLOCK_INIT);
 }
 
 /**
@@ -100,6 +106,8 @@ void boardInit(void)
 #if HAL_USE_WS281X
     ws281xObjectInit(&ws281x);
 #endif /* HAL_USE_WS281X */
+
+    boottime_mark(BOOTTIME_BOARD_INIT);
 }
 
 /**
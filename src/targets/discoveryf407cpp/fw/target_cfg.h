@@ -24,10 +24,39 @@
 #define PARTITION_FW            ((BaseNVMDevice*)&nvm_part_internal_flash_fw)
 #define PARTITION_BL_UPDATE     ((BaseNVMDevice*)&nvm_memory_bl_bin)
 
+/* Module state kept across resets in the 4 KiB backup SRAM. */
+#define SNAPSHOT_ENABLE         TRUE
+#define SNAPSHOT_DEVICE         ((BaseNVMDevice*)&nvm_memory_bkpsram)
+
 /* List modules here. */
 #define MOD_TEST_CPP                TRUE
 #define MOD_EFFECTS                 TRUE
 
+/* Thread load and stack report, relies on the kernel debug options.
+ * Threads profiling is not available in the tickless kernel. */
+#if !defined(NDEBUG) && !defined(KERNEL_TICKLESS)
+#define MOD_MONITOR                 TRUE
+#endif
+
+/* Timing zones on the hot paths, see profile.h. */
+#if !defined(NDEBUG)
+#define PROFILE_ENABLE              TRUE
+#endif
+
+/*
+ * Core coupled memory (ram4 in memory.ld). Zero wait states and no bus
+ * contention with the WS281x DMA, but DMA cannot access it either.
+ * .ram4_clear is zeroed by the startup code like .bss, before the module
+ * constructors run. Plain .ram4 is not initialized at all.
+ */
+#define RAM_SECTION_CCM             __attribute__((section(".ram4_clear")))
+
+/* Module instance including its thread stack and frame buffer, NOCCM
+ * keeps it in main RAM. */
+#if !defined(NOCCM)
+#define MOD_EFFECTS_SECTION         RAM_SECTION_CCM
+#endif
+
 #define DISPLAY_WIDTH 5
 #define DISPLAY_HEIGHT 1
 #define LEDCOUNT 5
@@ -0,0 +1,199 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "color_kernels.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace blinky;
+
+static_assert(COLOR_KERNELS_USE_DSP, "test expects the DSP kernels");
+
+namespace
+{
+
+/* Every (a, b) byte pair once, padded to whole pixels. */
+const size_t pairPixels = (256 * 256 + 2) / 3;
+
+class ColorKernelsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        a.assign(pairPixels * sizeof(Color), 0);
+        b.assign(pairPixels * sizeof(Color), 0);
+        for (size_t i = 0; i < 256 * 256; ++i)
+        {
+            a[i] = i & 0xFF;
+            b[i] = i >> 8;
+        }
+    }
+
+    Color* Pixels(std::vector<uint8_t>& bytes, size_t offset = 0)
+    {
+        return reinterpret_cast<Color*>(bytes.data() + offset);
+    }
+
+    std::vector<uint8_t> a;
+    std::vector<uint8_t> b;
+};
+
+/* Scalar references, straight from the kernel descriptions. */
+uint8_t AddSaturate(uint8_t d, uint8_t s)
+{
+    unsigned sum = d + s;
+    return (sum > 255) ? 255 : sum;
+}
+
+uint8_t Scale(uint8_t d, uint8_t factor)
+{
+    return d * (factor + 1u) / 256u;
+}
+
+uint8_t Lerp(uint8_t a, uint8_t b, uint8_t t)
+{
+    return (a * (256u - t) + b * t) / 256u;
+}
+
+} // namespace
+
+TEST_F(ColorKernelsTest, AddSaturateExhaustive)
+{
+    std::vector<uint8_t> dsp = a;
+    std::vector<uint8_t> scalar = a;
+
+    ColorAddSaturate(Pixels(dsp), Pixels(b), pairPixels);
+    portable::ColorAddSaturate(Pixels(scalar), Pixels(b), pairPixels);
+
+    for (size_t i = 0; i < dsp.size(); ++i)
+    {
+        ASSERT_EQ(AddSaturate(a[i], b[i]), dsp[i]) << "byte " << i;
+        ASSERT_EQ(dsp[i], scalar[i]) << "byte " << i;
+    }
+}
+
+TEST_F(ColorKernelsTest, ScaleExhaustive)
+{
+    for (unsigned factor = 0; factor < 256; ++factor)
+    {
+        std::vector<uint8_t> dsp = a;
+        std::vector<uint8_t> scalar = a;
+
+        ColorScale(Pixels(dsp), pairPixels, factor);
+        portable::ColorScale(Pixels(scalar), pairPixels, factor);
+
+        /* Bytes 0 to 255 in every lane of a word. */
+        for (size_t i = 0; i < 1024; ++i)
+        {
+            ASSERT_EQ(Scale(a[i], factor), dsp[i])
+                << "byte " << i << " factor " << factor;
+        }
+        ASSERT_EQ(scalar, dsp) << "factor " << factor;
+    }
+}
+
+TEST_F(ColorKernelsTest, LerpExhaustive)
+{
+    std::vector<uint8_t> dsp(a.size());
+    std::vector<uint8_t> scalar(a.size());
+
+    for (unsigned t = 0; t < 256; ++t)
+    {
+        ColorLerp(Pixels(dsp), Pixels(a), Pixels(b), pairPixels, t);
+        portable::ColorLerp(Pixels(scalar), Pixels(a), Pixels(b),
+                pairPixels, t);
+
+        for (size_t i = 0; i < dsp.size(); ++i)
+        {
+            ASSERT_EQ(Lerp(a[i], b[i], t), dsp[i])
+                << "byte " << i << " t " << t;
+        }
+        ASSERT_EQ(scalar, dsp) << "t " << t;
+    }
+}
+
+TEST_F(ColorKernelsTest, LerpInPlace)
+{
+    /* The effects blend into one of the sources. */
+    std::vector<uint8_t> dsp = a;
+    std::vector<uint8_t> scalar = a;
+
+    ColorLerp(Pixels(dsp), Pixels(dsp), Pixels(b), pairPixels, 77);
+    portable::ColorLerp(Pixels(scalar), Pixels(scalar), Pixels(b),
+            pairPixels, 77);
+
+    EXPECT_EQ(scalar, dsp);
+}
+
+TEST(ColorKernelsRandomTest, UnalignedAndTails)
+{
+    /* Pixel counts not a multiple of four bytes at every alignment, and
+     * the bytes around the pixels must stay untouched. */
+    std::mt19937 rng(0x1234567);
+    std::uniform_int_distribution<unsigned> byte(0, 255);
+
+    for (unsigned iteration = 0; iteration < 20000; ++iteration)
+    {
+        const size_t count = iteration % 13;
+        const size_t offset = (iteration / 13) % 4;
+        const uint8_t factor = byte(rng);
+        const size_t size = offset + count * sizeof(Color) + 4;
+
+        std::vector<uint8_t> pa(size), pb(size), dsp(size), scalar(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            pa[i] = byte(rng);
+            pb[i] = byte(rng);
+            dsp[i] = byte(rng);
+        }
+        scalar = dsp;
+
+        Color* d = reinterpret_cast<Color*>(dsp.data() + offset);
+        Color* s = reinterpret_cast<Color*>(scalar.data() + offset);
+        const Color* ca = reinterpret_cast<const Color*>(pa.data() + offset);
+        const Color* cb = reinterpret_cast<const Color*>(pb.data() + offset);
+
+        ColorAddSaturate(d, ca, count);
+        portable::ColorAddSaturate(s, ca, count);
+        ASSERT_EQ(scalar, dsp) << "add, iteration " << iteration;
+
+        ColorScale(d, count, factor);
+        portable::ColorScale(s, count, factor);
+        ASSERT_EQ(scalar, dsp) << "scale, iteration " << iteration;
+
+        ColorLerp(d, ca, cb, count, factor);
+        portable::ColorLerp(s, ca, cb, count, factor);
+        ASSERT_EQ(scalar, dsp) << "lerp, iteration " << iteration;
+
+        ColorClear(d, count);
+        portable::ColorClear(s, count);
+        ASSERT_EQ(scalar, dsp) << "clear, iteration " << iteration;
+    }
+}
+
+TEST(ColorKernelsRandomTest, ScaleFullFactorIsIdentity)
+{
+    Color pixels[5] = {{1, 2, 3}, {255, 254, 253}, {0, 128, 255},
+                       {17, 34, 51}, {200, 100, 50}};
+    Color expected[5];
+    std::memcpy(expected, pixels, sizeof(pixels));
+
+    ColorScale(pixels, 5, 255);
+
+    EXPECT_EQ(0, std::memcmp(expected, pixels, sizeof(pixels)));
+}
@@ -0,0 +1,51 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * The CMSIS SIMD intrinsics used by color_kernels.cpp, modeled after the
+ * instruction descriptions of the ARMv7-M Architecture Reference Manual.
+ */
+
+#ifndef _QHAL_H_
+#define _QHAL_H_
+
+#include <stdint.h>
+
+/* Zero extends bytes 0 and 2 into the two halfwords. */
+static inline uint32_t __UXTB16(uint32_t op1)
+{
+    return op1 & 0x00FF00FFu;
+}
+
+static inline uint32_t __ROR(uint32_t op1, uint32_t op2)
+{
+    op2 %= 32u;
+    if (op2 == 0u)
+        return op1;
+    return (op1 >> op2) | (op1 << (32u - op2));
+}
+
+/* Unsigned saturating add of the four bytes. */
+static inline uint32_t __UQADD8(uint32_t op1, uint32_t op2)
+{
+    uint32_t result = 0;
+    for (unsigned shift = 0; shift < 32u; shift += 8u)
+    {
+        uint32_t sum = ((op1 >> shift) & 0xFFu) + ((op2 >> shift) & 0xFFu);
+        result |= ((sum > 0xFFu) ? 0xFFu : sum) << shift;
+    }
+    return result;
+}
+
+#endif /* _QHAL_H_ */
@@ -0,0 +1,139 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "fat12_format.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace blinky;
+
+namespace
+{
+
+uint32_t LoadLe16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+/* Formats a volume image of @p sectors the way the logger does. */
+std::vector<uint8_t> Format(uint32_t sectors)
+{
+    Fat12Format format(sectors);
+    std::vector<uint8_t> image(sectors * FAT12_SECTOR_SIZE, 0xA5);
+
+    for (uint32_t s = 0; s < format.GetSystemSectors(); ++s)
+        format.FillSector(s, &image[s * FAT12_SECTOR_SIZE]);
+    return image;
+}
+
+/*
+ * The checks FatFS makes when it mounts a volume without partition
+ * table. Returns the number of clusters, zero if it would not mount as
+ * FAT12.
+ */
+uint32_t Mount(const std::vector<uint8_t>& image)
+{
+    const uint8_t* bs = image.data();
+
+    EXPECT_EQ(0x55, bs[510]);
+    EXPECT_EQ(0xAA, bs[511]);
+    EXPECT_EQ(0xEB, bs[0]);
+    EXPECT_EQ(0, memcmp(&bs[54], "FAT", 3));
+
+    EXPECT_EQ(static_cast<uint32_t>(FAT12_SECTOR_SIZE), LoadLe16(&bs[11]));
+    uint32_t clusterSize = bs[13];
+    uint32_t reserved = LoadLe16(&bs[14]);
+    uint32_t fats = bs[16];
+    uint32_t rootEntries = LoadLe16(&bs[17]);
+    uint32_t total = LoadLe16(&bs[19]);
+    uint32_t fatSize = LoadLe16(&bs[22]);
+
+    EXPECT_EQ(image.size() / FAT12_SECTOR_SIZE, total);
+    EXPECT_TRUE(clusterSize != 0 && (clusterSize & (clusterSize - 1)) == 0);
+    EXPECT_TRUE(fats == 1 || fats == 2);
+    EXPECT_NE(0u, reserved);
+    EXPECT_NE(0u, fatSize);
+    EXPECT_EQ(0u, rootEntries % (FAT12_SECTOR_SIZE / 32));
+
+    uint32_t system = reserved + fats * fatSize +
+            rootEntries / (FAT12_SECTOR_SIZE / 32);
+    if (total <= system)
+        return 0;
+    uint32_t clusters = (total - system) / clusterSize;
+    if (clusters > FAT12_MAX_CLUSTERS)
+        return 0;
+
+    /* The FAT covers all clusters plus the two reserved entries. */
+    uint32_t entries = clusters + 2;
+    uint32_t fatBytes = entries * 3 / 2 + (entries & 1);
+    EXPECT_GE(fatSize * FAT12_SECTOR_SIZE, fatBytes);
+
+    /* Media byte and end of chain, every cluster free. */
+    const uint8_t* fat = &bs[reserved * FAT12_SECTOR_SIZE];
+    EXPECT_EQ(bs[21], fat[0]);
+    EXPECT_EQ(0xFF, fat[1]);
+    EXPECT_EQ(0xFF, fat[2]);
+    for (uint32_t i = 3; i < fatSize * FAT12_SECTOR_SIZE; ++i)
+        EXPECT_EQ(0, fat[i]) << "FAT byte " << i;
+
+    /* No directory entries. */
+    const uint8_t* root = fat + fats * fatSize * FAT12_SECTOR_SIZE;
+    for (uint32_t i = 0; i < rootEntries * 32; ++i)
+        EXPECT_EQ(0, root[i]) << "root byte " << i;
+
+    return clusters;
+}
+
+} // namespace
+
+TEST(Fat12FormatTest, SmallVolume)
+{
+    /* The flash EEPROM emulation of blinky, about 12 KiB. */
+    std::vector<uint8_t> image = Format(24);
+    EXPECT_EQ(21u, Mount(image));
+}
+
+TEST(Fat12FormatTest, VolumeSizes)
+{
+    for (uint32_t sectors = 4; sectors < 4200; sectors += 7)
+    {
+        Fat12Format format(sectors);
+        if (format.GetSystemSectors() == 0)
+            continue;
+
+        std::vector<uint8_t> image = Format(sectors);
+        uint32_t clusters = Mount(image);
+        ASSERT_NE(0u, clusters) << sectors << " sectors";
+        /* At most one sector of the FAT is spare. */
+        EXPECT_GE(clusters + 1, sectors - format.GetSystemSectors());
+    }
+}
+
+TEST(Fat12FormatTest, TooSmall)
+{
+    /* Boot sector, FAT and root directory leave no cluster. */
+    EXPECT_EQ(0u, Fat12Format(0).GetSystemSectors());
+    EXPECT_EQ(0u, Fat12Format(3).GetSystemSectors());
+    EXPECT_EQ(3u, Fat12Format(4).GetSystemSectors());
+}
+
+TEST(Fat12FormatTest, TooLarge)
+{
+    /* Left to f_mkfs(), which picks FAT16 there. */
+    EXPECT_NE(0u, Fat12Format(4096).GetSystemSectors());
+    EXPECT_EQ(0u, Fat12Format(8192).GetSystemSectors());
+}
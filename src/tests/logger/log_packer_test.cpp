@@ -0,0 +1,218 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "log_packer.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace blinky;
+
+namespace
+{
+
+const size_t capacity = LogBlock::CAPACITY;
+
+/*
+ * The module thread and the writer around one packer. Blocks go to a
+ * temporary file one sector at a time, the way f_write() appends them to
+ * the volume, and are read back from there.
+ */
+class LogPackerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        file = std::tmpfile();
+        ASSERT_NE(nullptr, file);
+        packer.Subscribe();
+    }
+
+    void TearDown() override
+    {
+        if (file != nullptr)
+            std::fclose(file);
+    }
+
+    /* Samples numbered by their timestamp. */
+    void Produce(uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i, ++produced)
+        {
+            MotionSample sample = {};
+            sample.timestamp = produced;
+            sample.x = static_cast<int16_t>(produced);
+            sample.y = static_cast<int16_t>(produced >> 16);
+            sample.z = 16384;
+            sample.temperature = 25;
+            channel.Write(sample);
+        }
+    }
+
+    /* One wake-up of the module thread. */
+    void Collect(bool writerFree = true)
+    {
+        while (packer.Collect())
+            HandOver(writerFree);
+    }
+
+    void HandOver(bool writerFree)
+    {
+        const LogBlock* block = packer.HandOver(writerFree);
+        if (block == nullptr)
+        {
+            ++dropped;
+            return;
+        }
+        ASSERT_EQ(1u, std::fwrite(block, sizeof(*block), 1, file));
+    }
+
+    std::vector<LogBlock> ReadBack()
+    {
+        std::vector<LogBlock> log;
+        LogBlock block;
+
+        EXPECT_EQ(0, std::fseek(file, 0, SEEK_END));
+        EXPECT_EQ(0, std::ftell(file) % MOD_LOGGER_BLOCK_SIZE);
+        std::rewind(file);
+        while (std::fread(&block, sizeof(block), 1, file) == 1)
+            log.push_back(block);
+        return log;
+    }
+
+    /*
+     * Walks the log like a reader on the host does, every sample produced
+     * must be in there or counted as lost right before. Returns the
+     * number of samples accounted for.
+     */
+    static uint32_t Replay(const std::vector<LogBlock>& log)
+    {
+        uint32_t next = 0;
+        for (size_t i = 0; i < log.size(); ++i)
+        {
+            EXPECT_EQ(i, log[i].sequence);
+            EXPECT_LE(log[i].count, capacity);
+
+            next += log[i].lost;
+            for (size_t r = 0; r < log[i].count; ++r, ++next)
+            {
+                const LogRecord& record = log[i].records[r];
+                EXPECT_EQ(next, record.timestamp) << "block " << i;
+                EXPECT_EQ(static_cast<int16_t>(next), record.x);
+                EXPECT_EQ(16384, record.z);
+                EXPECT_EQ(25, record.temperature);
+            }
+        }
+        return next;
+    }
+
+    MotionChannel channel;
+    LogBlock blocks[2];
+    LogPacker packer{&channel, blocks};
+    FILE* file = nullptr;
+    uint32_t produced = 0;
+    uint32_t dropped = 0;
+};
+
+} // namespace
+
+TEST_F(LogPackerTest, WritesWholeSectors)
+{
+    /* Batches as the sensors publish them at 100 Hz. */
+    for (int batch = 0; batch < 10; ++batch)
+    {
+        Produce(20);
+        Collect();
+    }
+
+    std::vector<LogBlock> log = ReadBack();
+    ASSERT_EQ(200u / capacity, log.size());
+    for (const LogBlock& block : log)
+    {
+        EXPECT_EQ(capacity, block.count);
+        EXPECT_EQ(0u, block.lost);
+    }
+    EXPECT_EQ(log.size() * capacity, Replay(log));
+    EXPECT_FALSE(packer.IsEmpty());
+}
+
+TEST_F(LogPackerTest, ShutdownKeepsPartialBlock)
+{
+    Produce(10);
+    Collect();
+    ASSERT_FALSE(packer.IsEmpty());
+
+    HandOver(true);
+    EXPECT_TRUE(packer.IsEmpty());
+
+    std::vector<LogBlock> log = ReadBack();
+    ASSERT_EQ(1u, log.size());
+    EXPECT_EQ(10u, log[0].count);
+    EXPECT_EQ(produced, Replay(log));
+}
+
+TEST_F(LogPackerTest, OverrunsCountAsLost)
+{
+    /* The collector fell behind, the channel keeps its size - 1 newest. */
+    Produce(100);
+    Collect();
+    Produce(50);
+    Collect();
+    HandOver(true);
+
+    std::vector<LogBlock> log = ReadBack();
+    ASSERT_FALSE(log.empty());
+    EXPECT_EQ(100u - (MOD_SENSORS_MOTION_RING_SIZE - 1), log[0].lost);
+    EXPECT_EQ(produced, Replay(log));
+}
+
+TEST_F(LogPackerTest, BusyWriterDropsBlock)
+{
+    Produce(capacity);
+    Collect(false);
+    EXPECT_EQ(1u, dropped);
+    EXPECT_TRUE(packer.IsEmpty());
+
+    Produce(capacity);
+    Collect();
+
+    /* No gap in the sequence, the samples are in the lost field. */
+    std::vector<LogBlock> log = ReadBack();
+    ASSERT_EQ(1u, log.size());
+    EXPECT_EQ(capacity, log[0].lost);
+    EXPECT_EQ(produced, Replay(log));
+}
+
+TEST_F(LogPackerTest, LostBeyondFieldIsCarried)
+{
+    const uint32_t overrun = 70000;
+
+    Produce(overrun + MOD_SENSORS_MOTION_RING_SIZE - 1);
+    Collect();
+    Produce(capacity);
+    Collect();
+
+    std::vector<LogBlock> log = ReadBack();
+    ASSERT_EQ(2u, log.size());
+    EXPECT_EQ(UINT16_MAX, log[0].lost);
+    EXPECT_EQ(overrun - UINT16_MAX, log[1].lost);
+    EXPECT_EQ(overrun, log[0].records[0].timestamp);
+
+    uint32_t stored = 0;
+    for (const LogBlock& block : log)
+        stored += block.lost + block.count;
+    EXPECT_EQ(overrun + 2 * capacity, stored);
+}
@@ -0,0 +1,389 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "motion_filter.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace blinky;
+
+namespace
+{
+
+const double pi = 3.14159265358979323846;
+
+/* Binary angle units per radian. */
+const double angleScale = 32768.0 / pi;
+
+/* Double precision direct form I with the same coefficients. */
+class ReferenceBiquad
+{
+public:
+    explicit ReferenceBiquad(const BiquadCoeffs& c)
+        : b0(c.b0 / 16384.0), b1(c.b1 / 16384.0), b2(c.b2 / 16384.0),
+          a1(c.a1 / 16384.0), a2(c.a2 / 16384.0)
+    {
+    }
+
+    void Reset(double input)
+    {
+        x1 = x2 = y1 = y2 = input;
+    }
+
+    double Process(double x0)
+    {
+        double y0 = b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        return y0;
+    }
+
+private:
+    double b0, b1, b2, a1, a2;
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+};
+
+/* Bilinear transform of a 2nd order Butterworth low-pass. */
+void Butterworth(double cutoff, double rate, double* b, double* a)
+{
+    double k = std::tan(pi * cutoff / rate);
+    double norm = 1.0 / (1.0 + std::sqrt(2.0) * k + k * k);
+
+    b[0] = k * k * norm;
+    b[1] = 2.0 * b[0];
+    b[2] = b[0];
+    a[0] = 2.0 * (k * k - 1.0) * norm;
+    a[1] = (1.0 - std::sqrt(2.0) * k + k * k) * norm;
+}
+
+std::vector<AccelVector> RandomSamples(size_t count, int16_t amplitude)
+{
+    std::mt19937 rng(0xb1a4c7);
+    std::uniform_int_distribution<int> value(-amplitude, amplitude);
+    std::vector<AccelVector> samples(count);
+    for (AccelVector& s : samples)
+    {
+        s.x = value(rng);
+        s.y = value(rng);
+        s.z = value(rng);
+    }
+    return samples;
+}
+
+} // namespace
+
+TEST(BiquadFilterTest, CoefficientsMatchDesign)
+{
+    double b[3], a[2];
+    Butterworth(10.0, 100.0, b, a);
+
+    const BiquadCoeffs& c = biquadLowpass10Hz100Hz;
+    EXPECT_NEAR(b[0] * 16384.0, c.b0, 1.0);
+    EXPECT_NEAR(b[1] * 16384.0, c.b1, 1.0);
+    EXPECT_NEAR(b[2] * 16384.0, c.b2, 1.0);
+    EXPECT_NEAR(a[0] * 16384.0, c.a1, 1.0);
+    EXPECT_NEAR(a[1] * 16384.0, c.a2, 1.0);
+
+    /* Unity gain at DC. */
+    EXPECT_EQ(c.b0 + c.b1 + c.b2, 16384 + c.a1 + c.a2);
+}
+
+TEST(BiquadFilterTest, StillCoefficientsMatchDesign)
+{
+    double b[3], a[2];
+    Butterworth(10.0, 25.0, b, a);
+
+    const BiquadCoeffs& c = biquadLowpass10Hz25Hz;
+    EXPECT_NEAR(b[0] * 16384.0, c.b0, 1.0);
+    EXPECT_NEAR(b[1] * 16384.0, c.b1, 1.0);
+    EXPECT_NEAR(b[2] * 16384.0, c.b2, 1.0);
+    EXPECT_NEAR(a[0] * 16384.0, c.a1, 1.0);
+    EXPECT_NEAR(a[1] * 16384.0, c.a2, 1.0);
+
+    EXPECT_EQ(c.b0 + c.b1 + c.b2, 16384 + c.a1 + c.a2);
+}
+
+TEST(BiquadFilterTest, RandomInputMatchesReference)
+{
+    std::vector<AccelVector> samples = RandomSamples(2000, 16000);
+    std::vector<AccelVector> filtered = samples;
+
+    BiquadFilter filter(biquadLowpass10Hz100Hz);
+    filter.Reset({0, 0, 0});
+    filter.Process(filtered.data(), filtered.size());
+
+    ReferenceBiquad reference[3] = {
+        ReferenceBiquad(biquadLowpass10Hz100Hz),
+        ReferenceBiquad(biquadLowpass10Hz100Hz),
+        ReferenceBiquad(biquadLowpass10Hz100Hz),
+    };
+    for (ReferenceBiquad& r : reference)
+        r.Reset(0.0);
+
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        const int16_t* in = &samples[i].x;
+        const int16_t* out = &filtered[i].x;
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+            /* The rounding of the fed back output adds up to a few LSB. */
+            ASSERT_NEAR(reference[axis].Process(in[axis]), out[axis], 4.0)
+                    << "sample " << i << " axis " << axis;
+        }
+    }
+}
+
+TEST(BiquadFilterTest, ResetSettlesOnInput)
+{
+    std::vector<AccelVector> samples(50, AccelVector{-1000, 250, 16384});
+
+    BiquadFilter filter(biquadLowpass10Hz100Hz);
+    filter.Reset(samples[0]);
+    filter.Process(samples.data(), samples.size());
+
+    for (const AccelVector& s : samples)
+    {
+        EXPECT_EQ(-1000, s.x);
+        EXPECT_EQ(250, s.y);
+        EXPECT_EQ(16384, s.z);
+    }
+}
+
+TEST(BiquadFilterTest, FullScaleStepSaturates)
+{
+    /* The overshoot of a full scale step must clip, not wrap around. */
+    std::vector<AccelVector> samples(50, AccelVector{32767, -32768, 0});
+
+    BiquadFilter filter(biquadLowpass10Hz100Hz);
+    filter.Reset({-32768, 32767, 0});
+    filter.Process(samples.data(), samples.size());
+
+    for (size_t i = 1; i < samples.size(); ++i)
+    {
+        EXPECT_GE(samples[i].x, samples[i - 1].x) << "sample " << i;
+        EXPECT_LE(samples[i].y, samples[i - 1].y) << "sample " << i;
+    }
+    EXPECT_EQ(32767, samples.back().x);
+    EXPECT_EQ(-32768, samples.back().y);
+}
+
+TEST(BiquadFilterTest, SetCoeffsKeepsConstantInput)
+{
+    std::vector<AccelVector> samples(20, AccelVector{-1000, 250, 16384});
+
+    BiquadFilter filter(biquadLowpass10Hz100Hz);
+    filter.Reset(samples[0]);
+    filter.Process(samples.data(), 10);
+    filter.SetCoeffs(biquadLowpass10Hz25Hz);
+    filter.Process(samples.data() + 10, 10);
+
+    for (const AccelVector& s : samples)
+    {
+        EXPECT_EQ(-1000, s.x);
+        EXPECT_EQ(250, s.y);
+        EXPECT_EQ(16384, s.z);
+    }
+}
+
+TEST(GravityFilterTest, RandomInputMatchesReference)
+{
+    const uint8_t shift = 6;
+    const double alpha = 1.0 / (1 << shift);
+
+    std::vector<AccelVector> samples = RandomSamples(2000, 8000);
+    for (AccelVector& s : samples)
+        s.z += 16384;
+    std::vector<AccelVector> linear(samples.size());
+
+    GravityFilter filter(shift);
+    filter.Reset({0, 0, 16384});
+    filter.Process(samples.data(), linear.data(), samples.size());
+
+    double reference[3] = {0.0, 0.0, 16384.0};
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        const int16_t* in = &samples[i].x;
+        const int16_t* out = &linear[i].x;
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+            reference[axis] += alpha * (in[axis] - reference[axis]);
+            ASSERT_NEAR(in[axis] - reference[axis], out[axis], 2.0)
+                    << "sample " << i << " axis " << axis;
+        }
+    }
+
+    AccelVector gravity = filter.GetGravity();
+    EXPECT_NEAR(reference[0], gravity.x, 2.0);
+    EXPECT_NEAR(reference[1], gravity.y, 2.0);
+    EXPECT_NEAR(reference[2], gravity.z, 2.0);
+}
+
+TEST(GravityFilterTest, ConvergesOnConstantInput)
+{
+    std::vector<AccelVector> samples(2000, AccelVector{-32768, 32767, -7});
+    std::vector<AccelVector> linear(samples.size());
+
+    GravityFilter filter(6);
+    filter.Reset({32767, -32768, 0});
+    filter.Process(samples.data(), linear.data(), samples.size());
+
+    AccelVector gravity = filter.GetGravity();
+    EXPECT_EQ(-32768, gravity.x);
+    EXPECT_EQ(32767, gravity.y);
+    EXPECT_EQ(-7, gravity.z);
+    EXPECT_EQ(0, linear.back().x);
+    EXPECT_EQ(0, linear.back().y);
+    EXPECT_EQ(0, linear.back().z);
+}
+
+TEST(GravityFilterTest, SetShiftKeepsGravity)
+{
+    GravityFilter filter(6);
+    filter.Reset({-1000, 250, 16384});
+
+    filter.SetShift(4);
+    AccelVector gravity = filter.GetGravity();
+    EXPECT_EQ(-1000, gravity.x);
+    EXPECT_EQ(250, gravity.y);
+    EXPECT_EQ(16384, gravity.z);
+
+    filter.SetShift(6);
+    gravity = filter.GetGravity();
+    EXPECT_EQ(-1000, gravity.x);
+    EXPECT_EQ(250, gravity.y);
+    EXPECT_EQ(16384, gravity.z);
+}
+
+TEST(GravityFilterTest, ShiftSetsTimeConstant)
+{
+    /* After 2^shift samples of a step 1 - 1/e of it is reached. */
+    for (uint8_t shift : {4, 6})
+    {
+        std::vector<AccelVector> samples(1 << shift, AccelVector{0, 0, 16384});
+        std::vector<AccelVector> linear(samples.size());
+
+        GravityFilter filter(shift);
+        filter.Reset({0, 0, 0});
+        filter.Process(samples.data(), linear.data(), samples.size());
+
+        EXPECT_NEAR(16384 * (1.0 - std::exp(-1.0)), filter.GetGravity().z,
+                16384 * 0.02) << "shift " << unsigned(shift);
+    }
+}
+
+TEST(Atan2Test, AllDirectionsMatchReference)
+{
+    /* 0.1 degree is 18.2 binary angle units. */
+    const double maxError = 0.1 * 65536.0 / 360.0;
+
+    for (int step = 0; step < 3600; ++step)
+    {
+        double angle = step * 2.0 * pi / 3600;
+        for (double radius : {1000.0, 16384.0, 65535.0})
+        {
+            int32_t y = std::lround(radius * std::sin(angle));
+            int32_t x = std::lround(radius * std::cos(angle));
+
+            double expected = std::atan2(y, x) * angleScale;
+            double error = Atan2(y, x) - expected;
+
+            /* +180 and -180 degrees are the same direction. */
+            error = std::remainder(error, 65536.0);
+            ASSERT_LE(std::fabs(error), maxError)
+                    << "y " << y << " x " << x;
+        }
+    }
+}
+
+TEST(Atan2Test, Axes)
+{
+    EXPECT_EQ(0, Atan2(0, 0));
+    EXPECT_EQ(0, Atan2(0, 100));
+    EXPECT_EQ(16384, Atan2(100, 0));
+    EXPECT_EQ(-16384, Atan2(-100, 0));
+    EXPECT_EQ(-32768, Atan2(0, -100));
+    EXPECT_EQ(8192, Atan2(65535, 65535));
+    EXPECT_EQ(-8192, Atan2(-65535, 65535));
+}
+
+TEST(SquareRootTest, Edges)
+{
+    EXPECT_EQ(0u, SquareRoot(0));
+    EXPECT_EQ(1u, SquareRoot(1));
+    EXPECT_EQ(1u, SquareRoot(3));
+    EXPECT_EQ(2u, SquareRoot(4));
+    EXPECT_EQ(65535u, SquareRoot(0xFFFFFFFFu));
+    EXPECT_EQ(32768u, SquareRoot(1u << 30));
+    EXPECT_EQ(46340u, SquareRoot(2u << 30));
+
+    for (uint32_t root = 1; root < 65536; root += 97)
+    {
+        uint32_t square = root * root;
+        ASSERT_EQ(root, SquareRoot(square)) << square;
+        ASSERT_EQ(root - 1, SquareRoot(square - 1)) << square - 1;
+        ASSERT_EQ(root, SquareRoot(square + 1)) << square + 1;
+    }
+}
+
+TEST(SquareRootTest, RandomMatchesReference)
+{
+    std::mt19937 rng(0x5a17);
+    std::uniform_int_distribution<uint32_t> value;
+
+    for (int i = 0; i < 100000; ++i)
+    {
+        uint32_t v = value(rng);
+        ASSERT_EQ(static_cast<uint32_t>(std::floor(std::sqrt(double(v)))),
+                SquareRoot(v)) << v;
+    }
+}
+
+TEST(EstimateOrientationTest, MatchesReference)
+{
+    std::vector<AccelVector> samples = RandomSamples(10000, 32767);
+    samples.push_back({-32768, -32768, -32768});
+    samples.push_back({32767, -32768, -32768});
+    samples.push_back({0, -32768, 0});
+    samples.push_back({0, 0, -32768});
+
+    for (const AccelVector& g : samples)
+    {
+        double yz = std::sqrt(double(g.y) * g.y + double(g.z) * g.z);
+        double pitch = std::atan2(-g.x, std::floor(yz)) * angleScale;
+        double roll = std::atan2(g.y, g.z) * angleScale;
+
+        Orientation o = EstimateOrientation(g);
+        ASSERT_LE(std::fabs(std::remainder(o.pitch - pitch, 65536.0)), 19.0)
+                << g.x << " " << g.y << " " << g.z;
+        ASSERT_LE(std::fabs(std::remainder(o.roll - roll, 65536.0)), 19.0)
+                << g.x << " " << g.y << " " << g.z;
+    }
+}
+
+TEST(EstimateOrientationTest, FullScaleNegative)
+{
+    /* y * y + z * z is 2^31 here, one more than int32_t holds. */
+    Orientation o = EstimateOrientation({0, -32768, -32768});
+    EXPECT_EQ(0, o.pitch);
+    EXPECT_EQ(-24576, o.roll);
+
+    o = EstimateOrientation({-32768, -32768, -32768});
+    EXPECT_NEAR(std::atan2(32768.0, 46340.0) * angleScale, o.pitch, 19.0);
+}
@@ -0,0 +1,186 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "sample_clock.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <random>
+
+using namespace blinky;
+
+namespace
+{
+
+/* 100 Hz at 48 MHz. */
+const uint32_t nominal = 480000;
+
+/*
+ * Sensor sampling at its own rate, drained at every watermark after a
+ * random thread latency.
+ */
+class SensorSimulation
+{
+public:
+    SensorSimulation(uint32_t start, double period, size_t watermark)
+        : period(period), watermark(watermark), rng(0x3d9)
+    {
+        clock.Start(start, nominal);
+        std::uniform_real_distribution<double> phase(0.0, period);
+        first = start + phase(rng);
+    }
+
+    /*
+     * Drains one batch, returns the largest difference between a
+     * timestamp and the true sample time. The timestamps must keep going
+     * forward.
+     */
+    double Drain(bool lost = false)
+    {
+        std::uniform_real_distribution<double> latency(0.0, 0.9 * period);
+        double drained = first + (taken + watermark - 1) * period +
+                latency(rng);
+        size_t count = watermark;
+        if (lost)
+        {
+            /* The FIFO ran full and kept the newest samples only. */
+            drained += 100 * period;
+            taken += 100;
+        }
+
+        uint32_t timestamp = clock.Advance(Wrap(drained), count, lost);
+        uint32_t spacing = clock.GetPeriod();
+
+        double worst = 0.0;
+        for (size_t i = 0; i < count; ++i, ++taken)
+        {
+            uint32_t ts = timestamp + i * spacing;
+            if (started)
+            {
+                EXPECT_GT(static_cast<int32_t>(ts - previous), 0)
+                        << "sample " << taken;
+            }
+            previous = ts;
+            started = true;
+
+            double truth = first + taken * period;
+            int32_t error = static_cast<int32_t>(ts - Wrap(truth));
+            worst = std::max(worst, std::fabs(double(error)));
+        }
+        return worst;
+    }
+
+    SampleClock clock;
+
+private:
+    static uint32_t Wrap(double time)
+    {
+        return static_cast<uint32_t>(
+                static_cast<uint64_t>(std::llround(time)));
+    }
+
+    double period;
+    size_t watermark;
+    std::mt19937 rng;
+    double first;
+    size_t taken = 0;
+    uint32_t previous = 0;
+    bool started = false;
+};
+
+} // namespace
+
+TEST(SampleClockTest, NominalRate)
+{
+    SensorSimulation sensor(1000, nominal, 16);
+
+    for (int batch = 0; batch < 200; ++batch)
+    {
+        double error = sensor.Drain();
+        ASSERT_LT(error, nominal) << "batch " << batch;
+    }
+    EXPECT_NEAR(nominal, sensor.clock.GetPeriod(), nominal / 100);
+}
+
+TEST(SampleClockTest, FollowsSlowSensor)
+{
+    /* 5 % off, the period estimate has to catch up. */
+    const double period = nominal * 1.05;
+    SensorSimulation sensor(1000, period, 16);
+
+    for (int batch = 0; batch < 50; ++batch)
+        sensor.Drain();
+
+    for (int batch = 0; batch < 200; ++batch)
+    {
+        double error = sensor.Drain();
+        ASSERT_LT(error, nominal) << "batch " << batch;
+    }
+    EXPECT_NEAR(period, sensor.clock.GetPeriod(), nominal / 100);
+}
+
+TEST(SampleClockTest, FollowsFastSensorAcrossWrap)
+{
+    const double period = nominal * 0.95;
+    SensorSimulation sensor(0xFF000000u, period, 8);
+
+    for (int batch = 0; batch < 50; ++batch)
+        sensor.Drain();
+
+    /* 400 batches of 8 samples run past 2^32. */
+    for (int batch = 0; batch < 400; ++batch)
+    {
+        double error = sensor.Drain();
+        ASSERT_LT(error, nominal) << "batch " << batch;
+    }
+    EXPECT_NEAR(period, sensor.clock.GetPeriod(), nominal / 100);
+}
+
+TEST(SampleClockTest, AnchorsAgainAfterOverrun)
+{
+    SensorSimulation sensor(1000, nominal, 16);
+
+    for (int batch = 0; batch < 20; ++batch)
+        sensor.Drain();
+
+    /* Without the new anchor the timestamps would be 100 periods off. */
+    EXPECT_LT(sensor.Drain(true), nominal);
+    EXPECT_LT(sensor.Drain(), nominal);
+}
+
+TEST(SampleClockTest, PeriodStaysNearNominal)
+{
+    SampleClock clock;
+    clock.Start(0, nominal);
+
+    /* Drains far off the grid must not drag the period out of range. */
+    for (int batch = 1; batch < 100; ++batch)
+        clock.Advance(batch * 16 * nominal * 2, 16, false);
+
+    EXPECT_LE(clock.GetPeriod(), nominal + nominal / 8);
+}
+
+TEST(SampleClockTest, StartKeepsClockDeviation)
+{
+    const double period = nominal * 1.05;
+    SensorSimulation sensor(1000, period, 16);
+
+    for (int batch = 0; batch < 100; ++batch)
+        sensor.Drain();
+
+    /* Down to 25 Hz, the sensor is 5 % slow there as well. */
+    sensor.clock.Start(0, 4 * nominal);
+    EXPECT_NEAR(4 * period, sensor.clock.GetPeriod(), 4 * nominal / 100);
+}
@@ -0,0 +1,28 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "profile.h"
+
+#include <chrono>
+
+/*
+ * Profiling zones in host builds count nanoseconds of the monotonic
+ * clock, wrapping at 32 bit like the cycle counter on the target.
+ */
+uint32_t profile_host_now(void)
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
@@ -0,0 +1,136 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "profile.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <thread>
+
+static_assert(PROFILE_ENABLE, "test expects the profiling zones");
+
+namespace
+{
+
+class ProfileTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        profile_reset();
+    }
+
+    const profile_stats_t& Stats(enum profile_zone zone)
+    {
+        return profile_stats[zone];
+    }
+
+    void Sleep()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+};
+
+} // namespace
+
+TEST_F(ProfileTest, Aggregates)
+{
+    profile_record(PROFILE_DRAW_EFFECTS, 100);
+    profile_record(PROFILE_DRAW_EFFECTS, 50);
+    profile_record(PROFILE_DRAW_EFFECTS, 300);
+
+    const profile_stats_t& stats = Stats(PROFILE_DRAW_EFFECTS);
+    EXPECT_EQ(3u, stats.count);
+    EXPECT_EQ(50u, stats.min);
+    EXPECT_EQ(300u, stats.max);
+    EXPECT_EQ(450u, stats.total);
+
+    /* Other zones are not touched. */
+    EXPECT_EQ(0u, Stats(PROFILE_EFFECT_UPDATE).count);
+}
+
+TEST_F(ProfileTest, HistogramBins)
+{
+    const enum profile_zone zone = PROFILE_EFFECT_UPDATE;
+
+    profile_record(zone, 0);
+    profile_record(zone, 1);
+    profile_record(zone, 2);
+    profile_record(zone, 3);
+    profile_record(zone, 4);
+    profile_record(zone, 1023);
+    profile_record(zone, 1024);
+    profile_record(zone, 1u << (PROFILE_HISTOGRAM_BINS - 1));
+    profile_record(zone, UINT32_MAX);
+
+    const uint32_t* histogram = Stats(zone).histogram;
+    EXPECT_EQ(2u, histogram[0]);
+    EXPECT_EQ(2u, histogram[1]);
+    EXPECT_EQ(1u, histogram[2]);
+    EXPECT_EQ(1u, histogram[9]);
+    EXPECT_EQ(1u, histogram[10]);
+    /* The last bin takes all longer durations as well. */
+    EXPECT_EQ(2u, histogram[PROFILE_HISTOGRAM_BINS - 1]);
+    EXPECT_EQ(uint64_t(UINT32_MAX) + (1u << (PROFILE_HISTOGRAM_BINS - 1)) +
+            1024 + 1023 + 4 + 3 + 2 + 1, Stats(zone).total);
+}
+
+TEST_F(ProfileTest, Reset)
+{
+    profile_record(PROFILE_LIS3DH_DRAIN, 7);
+    profile_reset();
+
+    const profile_stats_t& stats = Stats(PROFILE_LIS3DH_DRAIN);
+    EXPECT_EQ(0u, stats.count);
+    EXPECT_EQ(0u, stats.histogram[2]);
+
+    /* The first duration after a reset sets the minimum again. */
+    profile_record(PROFILE_LIS3DH_DRAIN, 9);
+    EXPECT_EQ(9u, stats.min);
+}
+
+TEST_F(ProfileTest, BeginEndUsesHostClock)
+{
+    PROFILE_BEGIN(PROFILE_LIS3DH_TEMP);
+    Sleep();
+    PROFILE_END(PROFILE_LIS3DH_TEMP);
+
+    /* Nanoseconds on the host. */
+    const profile_stats_t& stats = Stats(PROFILE_LIS3DH_TEMP);
+    EXPECT_EQ(1u, stats.count);
+    EXPECT_GE(stats.max, 2000000u);
+    EXPECT_LT(stats.max, 1000000000u);
+}
+
+TEST_F(ProfileTest, ScopeEndsWithBlock)
+{
+    {
+        PROFILE_SCOPE(PROFILE_WS281X_UPDATE);
+        Sleep();
+        EXPECT_EQ(0u, Stats(PROFILE_WS281X_UPDATE).count);
+    }
+
+    EXPECT_EQ(1u, Stats(PROFILE_WS281X_UPDATE).count);
+    EXPECT_GE(Stats(PROFILE_WS281X_UPDATE).max, 2000000u);
+}
+
+TEST_F(ProfileTest, ZoneNames)
+{
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; ++zone)
+    {
+        ASSERT_NE(nullptr, profile_zone_names[zone]) << "zone " << zone;
+    }
+    EXPECT_STREQ("DrawEffects", profile_zone_names[PROFILE_DRAW_EFFECTS]);
+}
@@ -0,0 +1,280 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "motion_pipeline.hpp"
+#include "trace_fifo.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace blinky;
+
+namespace
+{
+
+const uint32_t coreClock = 48000000;
+
+/* The defaults of mod_sensors.hpp. */
+const MotionPipeline::Config config =
+{
+    {100, 16, &biquadLowpass10Hz100Hz, 6},
+    {25, 8, &biquadLowpass10Hz25Hz, 4},
+    1638,
+    819,
+    5000,
+    600000,
+    coreClock,
+};
+
+double Seconds(uint32_t cycles)
+{
+    return double(cycles) / coreClock;
+}
+
+/*
+ * Does what ModuleSensors does with the sensor, with TraceFifo in place
+ * of the LIS3DH, and reads the motion channel like a subscriber.
+ */
+class SensorsTest : public ::testing::Test
+{
+protected:
+    using MotionState = MotionPipeline::MotionState;
+
+    struct Transition
+    {
+        MotionState state;
+        uint32_t time;
+    };
+
+    explicit SensorsTest(double drift = 0.0) : fifo(coreClock, drift)
+    {
+    }
+
+    void Open(const char* trace, const MotionPipeline::Config& config)
+    {
+        pipeline = new MotionPipeline(config, &channel);
+        ASSERT_TRUE(fifo.Open(std::string(TRACE_DIR) + "/" + trace));
+        channel.Subscribe(&cursor);
+        SetMotionState(MotionState::Moving);
+    }
+
+    void TearDown() override
+    {
+        delete pipeline;
+    }
+
+    /* ModuleSensors::SetMotionState() */
+    void SetMotionState(MotionState state)
+    {
+        const MotionPipeline::Rate& rate = pipeline->GetRate(state);
+        fifo.SetDataRate(rate.hz);
+        fifo.SetWatermark(rate.watermark);
+        pipeline->SetState(state, fifo.Now());
+        transitions.push_back({state, fifo.Now()});
+    }
+
+    /* ModuleSensors::ReadBatch(), false at the end of the trace. */
+    bool ReadBatch(uint32_t latency)
+    {
+        uint32_t drained;
+        if (!fifo.WaitWatermark(latency, &drained))
+            return false;
+
+        AccelVector batch[LIS3DH_FIFO_DEPTH];
+        size_t count = fifo.Collect(batch, LIS3DH_FIFO_DEPTH);
+        bool lost = fifo.overruns != overruns;
+        overruns = fifo.overruns;
+
+        MotionState state = pipeline->Process(batch, count,
+                fifo.GetTemperature(), drained, lost);
+        if (state != pipeline->GetState())
+            SetMotionState(state);
+        if (pipeline->IsStandbyDue() && standbyDue == 0)
+            standbyDue = fifo.Now();
+
+        ++batches;
+        Subscriber();
+        return true;
+    }
+
+    /* Drains the channel, one thread latency between 0 and 5 ms. */
+    void Replay()
+    {
+        std::mt19937 rng(0x5e4);
+        std::uniform_int_distribution<uint32_t> latency(0, coreClock / 200);
+        while (ReadBatch(latency(rng)))
+        {
+        }
+    }
+
+    void Subscriber()
+    {
+        const MotionSample* samples;
+        size_t count;
+        while ((count = channel.Peek(&cursor, &samples)) > 0)
+        {
+            received.insert(received.end(), samples, samples + count);
+            ASSERT_TRUE(channel.Consume(&cursor, count));
+        }
+    }
+
+    /*
+     * Checks that the timestamps move forward and stay within one sample
+     * period of the time the sensor took the sample. Samples right after
+     * an overrun are skipped, the grid needs a batch to settle.
+     */
+    void CheckTimestamps(size_t skipFrom = SIZE_MAX, size_t skipTo = 0)
+    {
+        const std::vector<uint32_t>& truth = fifo.GetSampleTimes();
+        ASSERT_EQ(truth.size(), received.size());
+
+        for (size_t i = 0; i < received.size(); ++i)
+        {
+            if (i > 0)
+            {
+                ASSERT_GT(static_cast<int32_t>(received[i].timestamp -
+                        received[i - 1].timestamp), 0) << "sample " << i;
+            }
+            if (i >= skipFrom && i < skipTo)
+                continue;
+
+            /* A sample period at the slower rate. */
+            int32_t error = static_cast<int32_t>(received[i].timestamp -
+                    truth[i]);
+            ASSERT_LT(std::abs(error), int32_t(coreClock / 25))
+                    << "sample " << i << " at " << Seconds(truth[i]) << " s";
+        }
+    }
+
+    TraceFifo fifo;
+    MotionChannel channel;
+    MotionChannel::Cursor cursor;
+    MotionPipeline* pipeline = nullptr;
+    uint32_t overruns = 0;
+    uint32_t batches = 0;
+    uint32_t standbyDue = 0;
+    std::vector<Transition> transitions;
+    std::vector<MotionSample> received;
+};
+
+class SensorsDriftTest : public SensorsTest
+{
+protected:
+    /* The sensor clock runs 4 % slow. */
+    SensorsDriftTest() : SensorsTest(0.04)
+    {
+    }
+};
+
+} // namespace
+
+TEST_F(SensorsTest, DeskPickup)
+{
+    Open("desk_pickup.trace", config);
+    Replay();
+
+    /* Still after 5 s, picked up at 8 s and put down at 11 s. */
+    ASSERT_EQ(4u, transitions.size());
+    EXPECT_EQ(MotionState::Still, transitions[1].state);
+    EXPECT_NEAR(5.1, Seconds(transitions[1].time), 0.2);
+    EXPECT_EQ(MotionState::Moving, transitions[2].state);
+    EXPECT_NEAR(8.2, Seconds(transitions[2].time), 0.2);
+    EXPECT_EQ(MotionState::Still, transitions[3].state);
+    EXPECT_GT(Seconds(transitions[3].time), 16.0);
+    EXPECT_LT(Seconds(transitions[3].time), 18.0);
+    EXPECT_EQ(0u, standbyDue);
+
+    /* Every sample taken reached the subscriber. */
+    EXPECT_EQ(0u, fifo.overruns);
+    EXPECT_EQ(0u, cursor.overruns);
+    CheckTimestamps();
+
+    /* One wake-up per batch. */
+    EXPECT_EQ(batches, channel.GetEventSource()->broadcasts);
+    EXPECT_EQ(eventflags_t(MotionChannel::MOTION_CHANNEL_EVENT),
+            channel.GetEventSource()->flags);
+
+    /* Put down at pitch 20 and roll -30 degrees, 3641 and -5461 units. */
+    const MotionSample& last = received.back();
+    EXPECT_NEAR(3641, last.pitch, 60);
+    EXPECT_NEAR(-5461, last.roll, 60);
+    EXPECT_EQ(515, last.temperature);
+}
+
+TEST_F(SensorsTest, LinearAccelerationWhileWaved)
+{
+    Open("desk_pickup.trace", config);
+    Replay();
+
+    /* Gravity is removed while lying still, not while waved. */
+    int32_t still = 0;
+    int32_t waved = 0;
+    const std::vector<uint32_t>& truth = fifo.GetSampleTimes();
+    for (size_t i = 0; i < received.size(); ++i)
+    {
+        const MotionSample& s = received[i];
+        int32_t magnitude = std::abs(s.linearX) + std::abs(s.linearY) +
+                std::abs(s.linearZ);
+        double t = Seconds(truth[i]);
+        if (t > 1.0 && t < 8.0)
+            still = std::max(still, magnitude);
+        if (t > 9.0 && t < 10.0)
+            waved = std::max(waved, magnitude);
+    }
+    EXPECT_LT(still, config.stillThreshold);
+    EXPECT_GT(waved, 4 * config.moveThreshold);
+}
+
+TEST_F(SensorsTest, OverrunKeepsTimestampsInOrder)
+{
+    Open("desk_pickup.trace", config);
+
+    for (int i = 0; i < 10; ++i)
+        ASSERT_TRUE(ReadBatch(0));
+
+    /* 500 ms late, the FIFO overflows at 100 Hz. */
+    size_t before = received.size();
+    ASSERT_TRUE(ReadBatch(coreClock / 2));
+    EXPECT_EQ(1u, fifo.overruns);
+    EXPECT_EQ(before + LIS3DH_FIFO_DEPTH, received.size());
+
+    Replay();
+    EXPECT_EQ(1u, fifo.overruns);
+    CheckTimestamps(before, before + LIS3DH_FIFO_DEPTH);
+}
+
+TEST_F(SensorsTest, StandbyWhenStill)
+{
+    MotionPipeline::Config standby = config;
+    standby.standbyTime = 2000;
+
+    Open("desk_pickup.trace", standby);
+    Replay();
+
+    /* 2 s after the drop to the still rate at about 5.1 s. */
+    EXPECT_NEAR(7.1, Seconds(standbyDue), 0.4);
+}
+
+TEST_F(SensorsDriftTest, TimestampsFollowSensorClock)
+{
+    Open("desk_pickup.trace", config);
+    Replay();
+
+    EXPECT_EQ(0u, fifo.overruns);
+    CheckTimestamps();
+}
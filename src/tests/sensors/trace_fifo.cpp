@@ -0,0 +1,132 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "trace_fifo.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace blinky
+{
+
+bool TraceFifo::Open(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    lines.clear();
+    std::string text;
+    while (std::getline(file, text))
+    {
+        if (text.empty() || text[0] == '#')
+            continue;
+
+        std::istringstream fields(text);
+        uint64_t us;
+        int x, y, z, temp;
+        char comma;
+        if (!(fields >> us >> comma >> x >> comma >> y >> comma >> z >>
+                comma >> temp))
+        {
+            return false;
+        }
+
+        Line l;
+        l.time = us * clock / 1000000;
+        l.axes = {static_cast<int16_t>(x), static_cast<int16_t>(y),
+                  static_cast<int16_t>(z)};
+        l.temperature = temp;
+        lines.push_back(l);
+    }
+
+    line = 0;
+    fifo.clear();
+    now = 0;
+    next = 0.0;
+    return !lines.empty();
+}
+
+void TraceFifo::SetDataRate(uint16_t hz)
+{
+    period = clock * (1.0 + drift) / hz;
+    next = now + period;
+}
+
+void TraceFifo::SetWatermark(uint8_t watermark)
+{
+    this->watermark = watermark;
+    fifo.clear();
+    overflown = false;
+}
+
+bool TraceFifo::WaitWatermark(uint32_t latency, uint32_t* drained)
+{
+    while (fifo.size() < watermark)
+    {
+        if (next > lines.back().time)
+            return false;
+        now = std::llround(next);
+        TakeSample();
+    }
+
+    /* More samples come in until the thread gets to drain. */
+    uint64_t until = now + latency;
+    while (next <= until && next <= lines.back().time)
+    {
+        now = std::llround(next);
+        TakeSample();
+    }
+    now = until;
+
+    *drained = static_cast<uint32_t>(now);
+    return true;
+}
+
+size_t TraceFifo::Collect(AccelVector* samples, size_t max)
+{
+    if (overflown)
+        ++overruns;
+    overflown = false;
+
+    size_t count = 0;
+    while (count < max && !fifo.empty())
+    {
+        samples[count++] = fifo.front().axes;
+        sampleTimes.push_back(static_cast<uint32_t>(fifo.front().time));
+        fifo.pop_front();
+    }
+
+    /* The drain itself takes no time here. */
+    return count;
+}
+
+void TraceFifo::TakeSample()
+{
+    /* The newest reading of the trace at the sample time. */
+    while (line + 1 < lines.size() && lines[line + 1].time <= now)
+        ++line;
+
+    if (fifo.size() == LIS3DH_FIFO_DEPTH)
+    {
+        fifo.pop_front();
+        overflown = true;
+    }
+    fifo.push_back({now, lines[line].axes});
+    temperature = lines[line].temperature;
+    next += period;
+}
+
+} // namespace blinky
@@ -0,0 +1,135 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef TRACE_FIFO_HPP
+#define TRACE_FIFO_HPP
+
+#include "accel_vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace blinky
+{
+
+/**
+ * @brief   Takes the place of Lis3dhFifo, the sensor samples a trace.
+ * @details A trace is a text file with one reading per line:
+ *          @code
+ *          # time_us, x, y, z, temp
+ *          0, 120, -64, 16384, 512
+ *          10000, 118, -60, 16390, 512
+ *          @endcode
+ *          The simulated sensor samples the trace at its data rate, on a
+ *          clock which may be off by @p drift, and keeps the samples in a
+ *          FIFO of LIS3DH_FIFO_DEPTH in stream mode. Times are cycles of
+ *          a core clock of @p clock Hz, wrapping like cyclecount_get().
+ */
+class TraceFifo
+{
+public:
+    TraceFifo(uint32_t clock, double drift = 0.0)
+        : clock(clock), drift(drift)
+    {
+    }
+
+    /**
+     * @return  false if the trace could not be read.
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * @brief   Same as Lis3dhSetDataRate(), the FIFO keeps its samples.
+     */
+    void SetDataRate(uint16_t hz);
+
+    /**
+     * @brief   Same as Lis3dhFifo::SetWatermark(), empties the FIFO.
+     */
+    void SetWatermark(uint8_t watermark);
+
+    /**
+     * @brief   Runs the sensor until the watermark is reached, and
+     *          @p latency cycles further for the thread to wake up.
+     * @param[out] drained  time the drain starts
+     * @return  false at the end of the trace.
+     */
+    bool WaitWatermark(uint32_t latency, uint32_t* drained);
+
+    /**
+     * @brief   Same as Lis3dhFifo::Collect() after a drain, counts an
+     *          overflow in @p overruns.
+     */
+    size_t Collect(AccelVector* samples, size_t max);
+
+    /**
+     * @brief   Temperature of the newest sample.
+     */
+    int16_t GetTemperature() const
+    {
+        return temperature;
+    }
+
+    uint32_t Now() const
+    {
+        return static_cast<uint32_t>(now);
+    }
+
+    /**
+     * @brief   Times of all samples collected so far, in order.
+     */
+    const std::vector<uint32_t>& GetSampleTimes() const
+    {
+        return sampleTimes;
+    }
+
+    /* Number of drains that found the FIFO overflown. */
+    uint32_t overruns = 0;
+
+private:
+    struct Line
+    {
+        uint64_t time;
+        AccelVector axes;
+        int16_t temperature;
+    };
+
+    struct Sample
+    {
+        uint64_t time;
+        AccelVector axes;
+    };
+
+    void TakeSample();
+
+    uint32_t clock;
+    double drift;
+    std::vector<Line> lines;
+    size_t line = 0;
+    std::deque<Sample> fifo;
+    bool overflown = false;
+    uint8_t watermark = 1;
+    double period = 0.0;
+    double next = 0.0;
+    uint64_t now = 0;
+    int16_t temperature = 0;
+    std::vector<uint32_t> sampleTimes;
+};
+
+} // namespace blinky
+
+#endif /* TRACE_FIFO_HPP */
@@ -0,0 +1,32 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * The part of the tmb_effects color.h used by mod_effects, so the test
+ * builds without the effects library.
+ */
+
+#ifndef _COLOR_H_
+#define _COLOR_H_
+
+#include <stdint.h>
+
+struct Color
+{
+    uint8_t R;
+    uint8_t G;
+    uint8_t B;
+};
+
+#endif /* _COLOR_H_ */
@@ -0,0 +1,285 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "sprite.hpp"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+using namespace blinky;
+
+namespace
+{
+
+const Color black = {0, 0, 0};
+const Color red = {0xff, 0, 0};
+const Color green = {0, 0xff, 0};
+const Color blue = {0, 0, 0xff};
+
+/* 3x3 ring, the center is transparent. */
+const uint8_t ringMono[] =
+{
+    0xe0,
+    0xa0,
+    0xe0,
+};
+
+const Sprite ring = {3, 3, SpriteFormat::Mono, ringMono, nullptr};
+
+const Color palette[] = {black, red, green, blue};
+
+/* 2x2, index 0 in the lower right corner is transparent. */
+const uint8_t quadIndices[] =
+{
+    1, 2,
+    3, 0,
+};
+
+const Sprite quad = {2, 2, SpriteFormat::Palette, quadIndices, palette};
+
+class SpriteTest : public ::testing::Test
+{
+protected:
+    static const uint16_t width = 6;
+    static const uint16_t height = 4;
+
+    void SetUp() override
+    {
+        pixels.assign(width * height, black);
+        display = {width, height, pixels.data()};
+    }
+
+    /* The display as one string per row, '.' for black, 'r', 'g', 'b'
+     * for the primaries and '?' for anything else. */
+    std::vector<std::string> Rows() const
+    {
+        std::vector<std::string> rows;
+        for (uint16_t y = 0; y < height; ++y)
+        {
+            std::string row;
+            for (uint16_t x = 0; x < width; ++x)
+            {
+                const Color& c = pixels[y * width + x];
+                if (c.R == 0 && c.G == 0 && c.B == 0)
+                    row += '.';
+                else if (c.R == 0xff && c.G == 0 && c.B == 0)
+                    row += 'r';
+                else if (c.R == 0 && c.G == 0xff && c.B == 0)
+                    row += 'g';
+                else if (c.R == 0 && c.G == 0 && c.B == 0xff)
+                    row += 'b';
+                else
+                    row += '?';
+            }
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+    std::vector<Color> pixels;
+    DisplayBuffer display;
+};
+
+} // namespace
+
+TEST_F(SpriteTest, MonoInside)
+{
+    SpriteBlit(&display, 1, 1, ring, red);
+
+    std::vector<std::string> expected =
+    {
+        "......",
+        ".rrr..",
+        ".r.r..",
+        ".rrr..",
+    };
+    EXPECT_EQ(expected, Rows());
+}
+
+TEST_F(SpriteTest, MonoClippedTopLeft)
+{
+    SpriteBlit(&display, -1, -2, ring, red);
+
+    std::vector<std::string> expected =
+    {
+        "rr....",
+        "......",
+        "......",
+        "......",
+    };
+    EXPECT_EQ(expected, Rows());
+}
+
+TEST_F(SpriteTest, MonoClippedBottomRight)
+{
+    SpriteBlit(&display, 4, 2, ring, red);
+
+    std::vector<std::string> expected =
+    {
+        "......",
+        "......",
+        "....rr",
+        "....r.",
+    };
+    EXPECT_EQ(expected, Rows());
+}
+
+TEST_F(SpriteTest, FullyOutside)
+{
+    SpriteBlit(&display, -3, 0, ring, red);
+    SpriteBlit(&display, 6, 0, ring, red);
+    SpriteBlit(&display, 0, -3, ring, red);
+    SpriteBlit(&display, 0, 4, ring, red);
+
+    std::vector<std::string> expected(height, "......");
+    EXPECT_EQ(expected, Rows());
+}
+
+TEST_F(SpriteTest, PaletteTransparentIndex)
+{
+    pixels.assign(width * height, green);
+    SpriteBlit(&display, 5, 3, quad, black);
+    SpriteBlit(&display, 0, 0, quad, black);
+
+    std::vector<std::string> expected =
+    {
+        "rggggg",
+        "bggggg",
+        "gggggg",
+        "gggggr",
+    };
+    EXPECT_EQ(expected, Rows());
+}
+
+TEST_F(SpriteTest, GlyphClipped)
+{
+    GlyphCache cache;
+    const GlyphCache::Entry* glyph = cache.Lookup(font3x5, 'T', red, blue);
+    ASSERT_NE(nullptr, glyph);
+
+    /* Glyphs are opaque, the background is drawn as well. */
+    FontBlitGlyph(&display, 4, -1, font3x5, *glyph);
+
+    std::vector<std::string> expected =
+    {
+        "....br",
+        "....br",
+        "....br",
+        "....br",
+    };
+    EXPECT_EQ(expected, Rows());
+}
+
+TEST_F(SpriteTest, TextScrolledOutLeft)
+{
+    GlyphCache cache;
+
+    /* '1' and '-' are left of the display, "L" is cut in half. */
+    int16_t end = FontDrawText(&display, -9, -1, font3x5, "1-L", red, black,
+            &cache);
+
+    std::vector<std::string> expected =
+    {
+        "......",
+        "......",
+        "......",
+        "rr....",
+    };
+    EXPECT_EQ(3, end);
+    EXPECT_EQ(expected, Rows());
+    EXPECT_EQ(12, FontTextWidth(font3x5, "1-L"));
+}
+
+TEST_F(SpriteTest, TextStopsAtRightEdge)
+{
+    GlyphCache cache;
+
+    /* Only the first glyph is visible, the others never reach the cache. */
+    int16_t end = FontDrawText(&display, 3, 0, font3x5, "IIIII", red,
+            black, &cache);
+
+    EXPECT_EQ(3 + 5 * 4, end);
+    EXPECT_EQ("...rrr", Rows()[0]);
+
+    /* The cache holds 'I' only, four other glyphs fit without eviction. */
+    const GlyphCache::Entry* i = cache.Lookup(font3x5, 'I', red, black);
+    cache.Lookup(font3x5, 'A', red, black);
+    cache.Lookup(font3x5, 'B', red, black);
+    cache.Lookup(font3x5, 'C', red, black);
+    EXPECT_EQ(i, cache.Lookup(font3x5, 'I', red, black));
+}
+
+TEST(GlyphCacheTest, OutOfRange)
+{
+    GlyphCache cache;
+
+    EXPECT_EQ(nullptr, cache.Lookup(font3x5, 'a', red, black));
+    EXPECT_EQ(nullptr, cache.Lookup(font3x5, '\x1f', red, black));
+    EXPECT_NE(nullptr, cache.Lookup(font3x5, 'Z', red, black));
+}
+
+TEST(GlyphCacheTest, Hit)
+{
+    GlyphCache cache;
+
+    const GlyphCache::Entry* a = cache.Lookup(font3x5, 'A', red, black);
+    ASSERT_NE(nullptr, a);
+    EXPECT_EQ(a, cache.Lookup(font3x5, 'A', red, black));
+
+    /* Colors are part of the key. */
+    const GlyphCache::Entry* b = cache.Lookup(font3x5, 'A', green, black);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(0xff, b->pixels[0][1].G);
+    EXPECT_EQ(a, cache.Lookup(font3x5, 'A', red, black));
+}
+
+TEST(GlyphCacheTest, EvictsLeastRecentlyUsed)
+{
+    static_assert(MOD_EFFECTS_GLYPH_CACHE_SIZE == 4,
+            "test assumes the default cache size");
+
+    GlyphCache cache;
+
+    const GlyphCache::Entry* a = cache.Lookup(font3x5, 'A', red, black);
+    const GlyphCache::Entry* b = cache.Lookup(font3x5, 'B', red, black);
+    const GlyphCache::Entry* c = cache.Lookup(font3x5, 'C', red, black);
+    const GlyphCache::Entry* d = cache.Lookup(font3x5, 'D', red, black);
+
+    /* 'A' is used again, 'B' is now the oldest. */
+    EXPECT_EQ(a, cache.Lookup(font3x5, 'A', red, black));
+
+    const GlyphCache::Entry* e = cache.Lookup(font3x5, 'E', red, black);
+    EXPECT_EQ(b, e);
+    EXPECT_EQ('E', e->glyph);
+
+    /* 'C' is the oldest now. */
+    EXPECT_EQ(c, cache.Lookup(font3x5, 'F', red, black));
+    EXPECT_EQ(a, cache.Lookup(font3x5, 'A', red, black));
+    EXPECT_EQ(d, cache.Lookup(font3x5, 'B', red, black));
+}
+
+TEST(GlyphCacheTest, Flush)
+{
+    GlyphCache cache;
+
+    const GlyphCache::Entry* a = cache.Lookup(font3x5, 'A', red, black);
+    cache.Flush();
+
+    /* The flushed entry is reused and expanded again. */
+    const GlyphCache::Entry* b = cache.Lookup(font3x5, 'B', red, black);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ('B', b->glyph);
+}
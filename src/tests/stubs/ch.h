@@ -0,0 +1,59 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * The part of the ChibiOS kernel used by the code under host tests. The
+ * tests are single threaded, locking is not needed. Broadcasts are
+ * recorded in the event source instead of waking anyone up.
+ */
+
+#ifndef CH_H
+#define CH_H
+
+#include <stdint.h>
+
+typedef uint32_t syssts_t;
+typedef uint32_t eventflags_t;
+
+typedef struct
+{
+    /* Flags of all broadcasts so far. */
+    eventflags_t flags;
+    uint32_t broadcasts;
+} event_source_t;
+
+static inline syssts_t chSysGetStatusAndLockX(void)
+{
+    return 0;
+}
+
+static inline void chSysRestoreStatusX(syssts_t sts)
+{
+    (void)sts;
+}
+
+static inline void chEvtObjectInit(event_source_t* esp)
+{
+    esp->flags = 0;
+    esp->broadcasts = 0;
+}
+
+static inline void chEvtBroadcastFlags(event_source_t* esp,
+        eventflags_t flags)
+{
+    esp->flags |= flags;
+    ++esp->broadcasts;
+}
+
+#endif /* CH_H */